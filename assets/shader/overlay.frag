@@ -0,0 +1,10 @@
+#version 330 core
+in vec2 uv;
+in vec4 vertexColor;
+out vec4 color;
+uniform sampler2D atlas;
+void main(){
+	// Bars have no texture coordinates, glyphs take their coverage from the atlas
+	float coverage = uv.x < 0.0f ? 1.0f : texture(atlas, uv).r;
+	color = vec4(vertexColor.rgb, vertexColor.a * coverage);
+}
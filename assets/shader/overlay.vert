@@ -0,0 +1,11 @@
+#version 330 core
+layout(location = 0) in vec2 position;
+layout(location = 1) in vec2 texCoord;
+layout(location = 2) in vec4 tint;
+out vec2 uv;
+out vec4 vertexColor;
+void main(){
+	uv = texCoord;
+	vertexColor = tint;
+	gl_Position = vec4(position.xy, 0.0f, 1.0f);
+}
@@ -0,0 +1,5 @@
+#version 330 core
+out vec4 color;
+void main(){
+	color = vec4(0.1f, 0.5f, 0.1f, 1.0f);
+}
@@ -0,0 +1,119 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../src/AssetArchive.h"
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// **********************************************************************************************
+//	Asset load benchmark
+//	Usage: AssetLoad [assetsDir] [archive] [rounds]    (defaults ../assets, assets.pak, 20; run from bin/)
+// **********************************************************************************************
+//	Loads every asset as loose files (open, read into a buffer, close) and from the mapped
+//	archive (one mmap, then read through the mapping), cold and warm. Cold runs first evict
+//	the files from the page cache with posix_fadvise, which only works on Linux and only for
+//	clean pages; elsewhere cold and warm measure the same thing.
+
+static void Evict(const std::string& path)
+{
+#if defined(__linux__)
+	int descriptor = open(path.c_str(), O_RDONLY);
+	if (descriptor >= 0)
+	{
+		fdatasync(descriptor);
+		posix_fadvise(descriptor, 0, 0, POSIX_FADV_DONTNEED);
+		close(descriptor);
+	}
+#else
+	(void)path;
+#endif
+}
+
+static uint64_t LoadLoose(const std::vector<std::string>& files)
+{
+	uint64_t checksum = 0;
+	std::vector<uint8_t> buffer;
+	for (const std::string& path : files)
+	{
+		FILE* file = std::fopen(path.c_str(), "rb");
+		if (!file)
+			continue;
+		std::fseek(file, 0, SEEK_END);
+		buffer.resize((size_t)std::ftell(file));
+		std::fseek(file, 0, SEEK_SET);
+		size_t got = std::fread(buffer.data(), 1, buffer.size(), file);
+		std::fclose(file);
+		checksum += ChecksumAsset(buffer.data(), got);
+	}
+	return checksum;
+}
+
+static uint64_t LoadArchive(const std::string& path, const std::vector<std::string>& names)
+{
+	AssetArchive archive;
+	if (!archive.Open(path.c_str()))
+		return 0;
+	uint64_t checksum = 0;
+	for (const std::string& name : names)
+	{
+		AssetView view = archive.Find(name.c_str());
+		checksum += ChecksumAsset(view.data, view.size);
+	}
+	return checksum;
+}
+
+template <typename F>
+static double Milliseconds(F&& load, uint64_t& checksum)
+{
+	auto start = std::chrono::steady_clock::now();
+	checksum = load();
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[])
+{
+	std::filesystem::path root = argc > 1 ? argv[1] : "../assets";
+	std::string archivePath = argc > 2 ? argv[2] : "assets.pak";
+	int rounds = argc > 3 ? std::atoi(argv[3]) : 20;
+
+	AssetArchive archive;
+	if (!archive.Open(archivePath.c_str()))
+	{
+		std::cout << "Failed to open " << archivePath << " (build it with PackAssets)" << std::endl;
+		return EXIT_FAILURE;
+	}
+	std::vector<std::string> names, files;
+	for (uint32_t i = 0; i < archive.Count(); i++)
+	{
+		names.push_back(archive.Name(i));
+		files.push_back((root / archive.Name(i)).string());
+	}
+	archive.Close();
+
+	double looseCold = 0, looseWarm = 0, packedCold = 0, packedWarm = 0;
+	uint64_t looseSum = 0, packedSum = 0;
+	for (int r = 0; r < rounds; r++)
+	{
+		for (const std::string& file : files)
+			Evict(file);
+		looseCold += Milliseconds([&] { return LoadLoose(files); }, looseSum);
+		looseWarm += Milliseconds([&] { return LoadLoose(files); }, looseSum);
+
+		Evict(archivePath);
+		packedCold += Milliseconds([&] { return LoadArchive(archivePath, names); }, packedSum);
+		packedWarm += Milliseconds([&] { return LoadArchive(archivePath, names); }, packedSum);
+	}
+
+	std::cout << names.size() << " assets, " << rounds << " rounds, mean ms" << std::endl;
+	std::cout << "source\tcold\twarm" << std::endl;
+	std::cout << "loose\t" << looseCold / rounds << "\t" << looseWarm / rounds << std::endl;
+	std::cout << "archive\t" << packedCold / rounds << "\t" << packedWarm / rounds << std::endl;
+	std::cout << "checksums " << (looseSum == packedSum ? "match" : "DIFFER") << std::endl;
+	return looseSum == packedSum ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,130 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include "../src/MixKernels.h"
+
+// **********************************************************************************************
+//	Mixing kernel benchmark
+//	Usage: MixKernels [samples per buffer] [iterations]
+// **********************************************************************************************
+//	Runs every kernel at every SIMD level this CPU supports, reports millions of output samples
+//	per second and the speedup over the scalar loop, and checks each result against the scalar
+//	one: integer kernels must match exactly, float kernels to within one LSB.
+
+struct Buffers
+{
+	std::vector<Sint16> source, out;
+	std::vector<int32_t> acc;
+	std::vector<float> floats;
+};
+
+template <typename F>
+static double SamplesPerSecond(uint64_t iterations, size_t samples, F&& kernel)
+{
+	auto start = std::chrono::steady_clock::now();
+	for (uint64_t i = 0; i < iterations; i++)
+		kernel();
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return (double)iterations * samples / seconds / 1e6;
+}
+
+static int MaxDifference(const std::vector<Sint16>& a, const std::vector<Sint16>& b)
+{
+	int worst = 0;
+	for (size_t i = 0; i < a.size() && i < b.size(); i++)
+		worst = std::max(worst, std::abs(a[i] - b[i]));
+	return a.size() == b.size() ? worst : 65536;
+}
+
+int main(int argc, char* argv[])
+{
+	size_t samples = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 4096;
+	uint64_t iterations = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 20000;
+	const int channels = 2;
+	const uint32_t pitchStep = 65536 * 5 / 4;       // 1.25x, the HARD difficulty pitch
+	samples -= samples % channels;
+	size_t frames = samples / channels;
+	size_t sourceFrames = frames * 2;
+
+	Buffers b;
+	b.source.resize(sourceFrames * channels);
+	uint32_t noise = 0xC0FFEE;
+	for (Sint16& s : b.source)
+	{
+		noise ^= noise << 13;
+		noise ^= noise >> 17;
+		noise ^= noise << 5;
+		s = (Sint16)noise;
+	}
+	b.acc.assign(samples, 0);
+	b.out.assign(samples, 0);
+	b.floats.assign(samples, 0.0f);
+
+	// Every kernel writes its result into out so it can be compared with the scalar run
+	struct Kernel
+	{
+		const char* name;
+		void (*run)(const MixKernelTable&, Buffers&, size_t, size_t, uint32_t);
+	};
+	const Kernel kernels[] = {
+		{"mixAdd", [](const MixKernelTable& k, Buffers& b, size_t n, size_t, uint32_t) {
+			std::fill(b.acc.begin(), b.acc.end(), 0);
+			for (int v = 0; v < 4; v++)
+				k.mixAdd(b.acc.data(), b.source.data() + v * 2, n, 24000);
+			k.saturate(b.out.data(), b.acc.data(), n);
+		}},
+		{"gain", [](const MixKernelTable& k, Buffers& b, size_t n, size_t, uint32_t) {
+			std::copy(b.source.begin(), b.source.begin() + n, b.out.begin());
+			k.gain(b.out.data(), n, 20000);
+		}},
+		{"s16>f32>s16", [](const MixKernelTable& k, Buffers& b, size_t n, size_t, uint32_t) {
+			k.toFloat(b.floats.data(), b.source.data(), n);
+			k.fromFloat(b.out.data(), b.floats.data(), n);
+		}},
+		{"linear", [](const MixKernelTable& k, Buffers& b, size_t n, size_t sourceFrames, uint32_t step) {
+			uint64_t position = 3 << 15;
+			k.resampleLinear(b.out.data(), n / 2, b.source.data(), sourceFrames, 2, position, step);
+		}},
+		{"linear mono", [](const MixKernelTable& k, Buffers& b, size_t n, size_t sourceFrames, uint32_t step) {
+			uint64_t position = 3 << 15;
+			k.resampleLinear(b.out.data(), n, b.source.data(), sourceFrames * 2, 1, position, step);
+		}},
+		{"cubic", [](const MixKernelTable& k, Buffers& b, size_t n, size_t sourceFrames, uint32_t step) {
+			uint64_t position = 3 << 15;
+			k.resampleCubic(b.out.data(), n / 2, b.source.data(), sourceFrames, 2, position, step);
+		}},
+	};
+
+	const eSimdLevel levels[] = {eSimdLevel::SCALAR, eSimdLevel::SSE2, eSimdLevel::AVX2};
+	std::cout << "samples=" << samples << " iterations=" << iterations << " dispatch=" << MixKernels().name << std::endl;
+	std::cout << "kernel\t\tlevel\tMsamples/s\tspeedup\tmax diff" << std::endl;
+	bool ok = true;
+
+	for (const Kernel& kernel : kernels)
+	{
+		std::vector<Sint16> reference;
+		double baseRate = 0.0;
+		for (eSimdLevel level : levels)
+		{
+			const MixKernelTable* table = MixKernelsFor(level);
+			if (table == nullptr)
+				continue;
+			double rate = SamplesPerSecond(iterations, samples, [&] { kernel.run(*table, b, samples, sourceFrames, pitchStep); });
+			if (reference.empty())
+			{
+				reference = b.out;
+				baseRate = rate;
+			}
+			int difference = MaxDifference(reference, b.out);
+			bool exact = std::string(kernel.name) != "cubic" && std::string(kernel.name) != "s16>f32>s16";
+			if (difference > (exact ? 0 : 1))
+				ok = false;
+			std::cout << std::left << std::setw(16) << kernel.name << table->name << "\t" << rate << "\t\t"
+				<< rate / baseRate << "\t" << difference << std::endl;
+		}
+	}
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,64 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include "../src/AudioMixer.h"
+
+// **********************************************************************************************
+//	Mixer throughput benchmark
+//	Usage: MixerThroughput [seconds of audio per run] [buffer frames]
+// **********************************************************************************************
+//	Mixes synthetic looping clips at 1..MAX_VOICES simultaneous voices, as fast as possible
+//	instead of in real time, and reports how much faster than real time the mixer runs.
+
+int main(int argc, char* argv[])
+{
+	int seconds = argc > 1 ? std::atoi(argv[1]) : 60;
+	int bufferFrames = argc > 2 ? std::atoi(argv[2]) : 512;
+	const int rate = 44100, channels = 2;
+	const Uint32 clipFrames = rate * 2;
+
+	// A clip longer than the render keeps every voice busy for the whole run
+	std::vector<Sint16> clip((size_t)clipFrames * channels);
+	uint32_t noise = 0x12345678;
+	for (Sint16& s : clip)
+	{
+		noise ^= noise << 13;
+		noise ^= noise >> 17;
+		noise ^= noise << 5;
+		s = (Sint16)(noise >> 18);
+	}
+
+	std::vector<Sint16> out((size_t)bufferFrames * channels);
+	std::cout << "seconds=" << seconds << " buffer=" << bufferFrames << std::endl;
+	std::cout << "voices\tms\tx realtime\tvoice-frames/ms\tchecksum" << std::endl;
+
+	for (int voices = 1; voices <= MAX_VOICES; voices *= 2)
+	{
+		AudioMixer mixer;
+		mixer.SetFormat(channels, bufferFrames, rate);
+		int id = mixer.AddClip(clip.data(), clipFrames);
+		uint64_t total = (uint64_t)seconds * rate, mixed = 0, checksum = 0;
+		auto start = std::chrono::steady_clock::now();
+
+		while (mixed < total)
+		{
+			// Retrigger whatever finished so the voice count stays constant
+			while (mixer.ActiveVoices() < voices)
+			{
+				for (int v = mixer.ActiveVoices(); v < voices; v++)
+					mixer.Play(id, 0.25f);
+				mixer.Mix(out.data(), 0);
+			}
+			mixer.Mix(out.data(), bufferFrames);
+			checksum += (uint16_t)out[mixed % out.size()];
+			mixed += bufferFrames;
+		}
+
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		std::cout << voices << "\t" << ms << "\t" << (seconds * 1000.0) / ms << "\t\t"
+			<< (double)mixed * voices / ms << "\t\t" << checksum << std::endl;
+	}
+	return EXIT_SUCCESS;
+}
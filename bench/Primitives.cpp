@@ -0,0 +1,241 @@
+#include <cstdint>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "../src/Core.h"
+#include "../src/GameState.h"
+
+// **********************************************************************************************
+//	Math, transform and collision primitive benchmarks (Google Benchmark)
+//	Usage: Primitives [--benchmark_filter=regex] [--benchmark_out=primitives.json --benchmark_out_format=json]
+// **********************************************************************************************
+
+// Inputs come from an array the optimizer cannot see through, so nothing folds to a constant
+static const int POINTS = 1024;
+static Vector points[POINTS];
+
+static void FillPoints()
+{
+	SimRandom rng;
+	rng.Seed(7);
+	for (Vector& p : points)
+		p = GenerateRandomPoint(rng);
+}
+
+// **********************************************************************************************
+//	Vector
+// **********************************************************************************************
+
+static void BM_VectorArithmetic(benchmark::State& state)
+{
+	int i = 0;
+	for (auto _ : state)
+	{
+		const Vector& a = points[i];
+		const Vector& b = points[(i + 1) & (POINTS - 1)];
+		Vector v = (a + b) * 0.5f - b / 3.0f;
+		v += a;
+		v -= b;
+		v *= 2.0f;
+		v /= 4.0f;
+		benchmark::DoNotOptimize(v);
+		i = (i + 1) & (POINTS - 1);
+	}
+}
+BENCHMARK(BM_VectorArithmetic);
+
+static void BM_VectorDistance(benchmark::State& state)
+{
+	int i = 0;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(Vector::Distance(points[i], points[(i + 1) & (POINTS - 1)]));
+		i = (i + 1) & (POINTS - 1);
+	}
+}
+BENCHMARK(BM_VectorDistance);
+
+static void BM_FollowLeader(benchmark::State& state)
+{
+	int i = 0;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(FollowLeader(points[i], points[(i + 1) & (POINTS - 1)], TAIL_SPACING));
+		i = (i + 1) & (POINTS - 1);
+	}
+}
+BENCHMARK(BM_FollowLeader);
+
+// **********************************************************************************************
+//	Transform
+// **********************************************************************************************
+
+static void BM_GenQuadVertices(benchmark::State& state)
+{
+	float verts[8];
+	int i = 0;
+	for (auto _ : state)
+	{
+		Transform(points[i]).GenQuadVertices(0.025f, verts);
+		benchmark::DoNotOptimize(verts);
+		benchmark::ClobberMemory();
+		i = (i + 1) & (POINTS - 1);
+	}
+}
+BENCHMARK(BM_GenQuadVertices);
+
+static void BM_Translate(benchmark::State& state)
+{
+	Transform transform;
+	float verts[8];
+	transform.GenQuadVertices(0.025f, verts);
+	int i = 0;
+	for (auto _ : state)
+	{
+		transform.Translate(verts, points[i].x * 1e-3f, points[i].y * 1e-3f);
+		benchmark::DoNotOptimize(verts);
+		benchmark::ClobberMemory();
+		i = (i + 1) & (POINTS - 1);
+	}
+}
+BENCHMARK(BM_Translate);
+
+static void BM_Rotate(benchmark::State& state)
+{
+	float verts[8];
+	Transform().GenQuadVertices(0.025f, verts);
+	int i = 0;
+	for (auto _ : state)
+	{
+		Transform::Rotate(verts, points[i].x);
+		benchmark::DoNotOptimize(verts);
+		benchmark::ClobberMemory();
+		i = (i + 1) & (POINTS - 1);
+	}
+}
+BENCHMARK(BM_Rotate);
+
+static void BM_Scale(benchmark::State& state)
+{
+	float verts[8];
+	Transform().GenQuadVertices(0.025f, verts);
+	int i = 0;
+	for (auto _ : state)
+	{
+		// Alternate up and down so the vertices stay finite
+		float s = (i & 1) ? 1.25f : 0.8f;
+		Transform::Scale(verts, s, s);
+		benchmark::DoNotOptimize(verts);
+		benchmark::ClobberMemory();
+		i = (i + 1) & (POINTS - 1);
+	}
+}
+BENCHMARK(BM_Scale);
+
+// **********************************************************************************************
+//	Collision and random points
+// **********************************************************************************************
+
+static void BM_HasCollided(benchmark::State& state)
+{
+	std::vector<Entity> entities;
+	entities.reserve(POINTS);
+	for (const Vector& p : points)
+		entities.emplace_back(p, 0.030f);
+	int i = 0;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(HasCollided(entities[i], entities[(i + 1) & (POINTS - 1)]));
+		i = (i + 1) & (POINTS - 1);
+	}
+}
+BENCHMARK(BM_HasCollided);
+
+static void BM_GenerateRandomPoint(benchmark::State& state)
+{
+	SimRandom rng;
+	rng.Seed(42);
+	for (auto _ : state)
+		benchmark::DoNotOptimize(GenerateRandomPoint(rng));
+}
+BENCHMARK(BM_GenerateRandomPoint);
+
+// **********************************************************************************************
+//	Tail follow loop
+// **********************************************************************************************
+//	Both versions move every segment toward the one ahead of it, last to first, and test it
+//	against the head, as one tick does. The head circles so segments never collapse onto each
+//	other. Items processed are tail segments.
+
+static Vector CircleHead(int64_t tick)
+{
+	float angle = (float)tick * 0.01f;
+	return {0.5f * std::cos(angle), 0.5f * std::sin(angle)};
+}
+
+// The loop in UpdateGame (src/main.cpp) over Entities
+static void BM_TailFollowEntity(benchmark::State& state)
+{
+	size_t length = (size_t)state.range(0);
+	Entity snake(CircleHead(0), 0.035f);
+	std::vector<Entity> tails;
+	tails.reserve(length);
+	for (size_t i = 0; i < length; i++)
+		tails.emplace_back(Vector(0.5f, -TAIL_SPACING * (float)(i + 1)), 0.030f);
+
+	int64_t tick = 0;
+	int64_t collisions = 0;
+	for (auto _ : state)
+	{
+		snake.transform.position = CircleHead(++tick);
+		for (int i = (int)tails.size() - 1; i >= 0; i--)
+		{
+			const Vector& leader = (i == 0) ? snake.transform.position : tails[i - 1].transform.position;
+			tails[i].SetPosition(FollowLeader(leader, tails[i].transform.position, TAIL_SPACING), 0.030f);
+			if (i > 0 && HasCollided(snake, tails[i]))
+				collisions++;
+		}
+	}
+	benchmark::DoNotOptimize(collisions);
+	state.SetItemsProcessed(state.iterations() * (int64_t)length);
+}
+BENCHMARK(BM_TailFollowEntity)->RangeMultiplier(10)->Range(10, 1000000)->Unit(benchmark::kMicrosecond);
+
+// The loop in StepGame (src/GameState.h) over plain Segments
+static void BM_TailFollowSegment(benchmark::State& state)
+{
+	size_t length = (size_t)state.range(0);
+	std::vector<Segment> tails(length);
+	for (size_t i = 0; i < length; i++)
+		tails[i].position = Vector(0.5f, -TAIL_SPACING * (float)(i + 1));
+
+	int64_t tick = 0;
+	int64_t collisions = 0;
+	for (auto _ : state)
+	{
+		Vector head = CircleHead(++tick);
+		for (int i = (int)length - 1; i >= 0; i--)
+		{
+			const Vector& leader = (i == 0) ? head : tails[i - 1].position;
+			Segment& segment = tails[i];
+			segment.oldPosition = segment.position;
+			segment.position = FollowLeader(leader, segment.position, TAIL_SPACING);
+			if (i > 0 && Vector::Distance(head, segment.position) < TAIL_SCALE * 2)
+				collisions++;
+		}
+		benchmark::ClobberMemory();
+	}
+	benchmark::DoNotOptimize(collisions);
+	state.SetItemsProcessed(state.iterations() * (int64_t)length);
+}
+BENCHMARK(BM_TailFollowSegment)->RangeMultiplier(10)->Range(10, 1000000)->Unit(benchmark::kMicrosecond);
+
+int main(int argc, char* argv[])
+{
+	FillPoints();
+	benchmark::Initialize(&argc, argv);
+	if (benchmark::ReportUnrecognizedArguments(argc, argv))
+		return 1;
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+	return 0;
+}
@@ -0,0 +1,70 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../src/Replay.h"
+
+// **********************************************************************************************
+//	Replay playback benchmark
+//	Usage: ReplayPlayback [--rounds=N] replay...
+// **********************************************************************************************
+//	Plays recorded sessions through GameState and StepGame with no window, no SDL and no audio,
+//	N times each, and reports simulated frames (ticks) per second per replay and overall. The
+//	checksum of the final states has to match between builds of the same source.
+
+int main(int argc, char* argv[])
+{
+	int rounds = 200;
+	std::vector<std::string> paths;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg.rfind("--rounds=", 0) == 0)
+			rounds = std::max(1, std::atoi(arg.c_str() + 9));
+		else
+			paths.push_back(arg);
+	}
+	if (paths.empty())
+	{
+		std::cout << "Usage: ReplayPlayback [--rounds=N] replay..." << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	static GameState state;
+	uint64_t checksum = 0;
+	uint64_t totalTicks = 0;
+	double totalSeconds = 0.0;
+	for (const std::string& path : paths)
+	{
+		Replay replay;
+		if (!replay.Load(path))
+		{
+			std::cout << "Cannot read replay " << path << std::endl;
+			return EXIT_FAILURE;
+		}
+
+		uint64_t fruit = 0;
+		auto start = std::chrono::steady_clock::now();
+		for (int round = 0; round < rounds; round++)
+		{
+			StartReplayState(state, replay);
+			size_t next = 0;
+			for (uint32_t frame = 0; frame < (uint32_t)replay.deltaMs.size(); frame++)
+				fruit += (PlayReplayFrame(state, replay, frame, next) & EVENT_ATE_FRUIT) ? 1 : 0;
+			checksum += state.score + state.currentTime + state.rng.state;
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		uint64_t ticks = (uint64_t)rounds * replay.deltaMs.size();
+		totalTicks += ticks;
+		totalSeconds += seconds;
+
+		std::string name = path.substr(path.find_last_of("/\\") + 1);
+		std::cout << "[Bench] " << name << " (replay, " << replay.deltaMs.size() << " frames x " << rounds << ", "
+			<< fruit / (uint64_t)rounds << " fruit): ticks/s " << (double)ticks / seconds << std::endl;
+	}
+	std::cout << "[Bench] total: ticks/s " << (double)totalTicks / totalSeconds << "  checksum " << checksum << std::endl;
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,84 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../src/GameState.h"
+#include "../src/TaskRunner.h"
+
+// **********************************************************************************************
+//	Scaling benchmark for the TaskRunner
+//	Usage: RunnerScaling [simulations] [maxThreads] [--pin]
+// **********************************************************************************************
+
+// One headless session: a randomly steered snake stepped at 60 Hz, restarted on game over
+static uint64_t SimulateSession(uint64_t seed, int ticks)
+{
+	GameState state;
+	InitGameState(state, seed);
+	uint64_t total = 0;
+
+	for (int t = 0; t < ticks; t++)
+	{
+		if (t % 12 == 0)
+			SteerGame(state, (eDirection)(1 + state.rng.Next() % 4));
+		StepGame(state, 16);
+		if (state.gameOver)
+		{
+			total += state.score;
+			InitGameState(state, state.rng.Next() + 1ull);
+		}
+	}
+	return total * 1000003ull + state.score;
+}
+
+int main(int argc, char* argv[])
+{
+	size_t simulations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 4096;
+	unsigned int maxThreads = argc > 2 ? (unsigned int)std::strtoul(argv[2], nullptr, 10) : std::thread::hardware_concurrency();
+	bool pin = argc > 3 && std::string(argv[3]) == "--pin";
+	const int ticks = 20000;
+	const uint64_t batchSeed = 0x5EED;
+
+	if (maxThreads == 0)
+		maxThreads = 1;
+
+	std::vector<unsigned int> threadCounts;
+	for (unsigned int t = 1; t < maxThreads; t *= 2)
+		threadCounts.push_back(t);
+	threadCounts.push_back(maxThreads);
+
+	std::vector<uint64_t> reference;
+	double baseSeconds = 0.0;
+
+	std::cout << "simulations=" << simulations << " ticks=" << ticks << " pin=" << (pin ? "yes" : "no") << std::endl;
+	std::cout << "threads\tseconds\tsims/s\tspeedup\tefficiency\tsteals\tdeterministic" << std::endl;
+
+	for (unsigned int threads : threadCounts)
+	{
+		TaskRunner runner(threads, pin);
+		std::vector<uint64_t> results(simulations);
+
+		auto start = std::chrono::steady_clock::now();
+		runner.ParallelFor(simulations, [&](size_t i) {
+			results[i] = SimulateSession(TaskRunner::TaskSeed(batchSeed, i), ticks);
+		});
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		if (reference.empty())
+		{
+			reference = results;
+			baseSeconds = seconds;
+		}
+
+		double speedup = baseSeconds / seconds;
+		std::cout << threads << "\t" << seconds << "\t" << (double)simulations / seconds << "\t"
+			<< speedup << "\t" << speedup / threads << "\t\t" << runner.StealCount() << "\t"
+			<< (results == reference ? "yes" : "NO") << std::endl;
+
+		if (results != reference)
+			return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,68 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include "../src/GameState.h"
+
+// **********************************************************************************************
+//	Snapshot clone benchmark
+//	Usage: SnapshotClone [segments] [iterations]
+// **********************************************************************************************
+
+static GameState source;
+
+template <typename F>
+static double ClonesPerSecond(uint64_t iterations, F&& clone)
+{
+	auto start = std::chrono::steady_clock::now();
+	for (uint64_t i = 0; i < iterations; i++)
+		clone(i);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return (double)iterations / seconds;
+}
+
+int main(int argc, char* argv[])
+{
+	uint32_t segments = argc > 1 ? (uint32_t)std::strtoul(argv[1], nullptr, 10) : 1000;
+	uint64_t iterations = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 2000000;
+	if (segments > (uint32_t)MAX_TAIL_SEGMENTS)
+		segments = MAX_TAIL_SEGMENTS;
+
+	InitGameState(source, 42);
+	source.tailCount = segments;
+	for (uint32_t i = 0; i < segments; i++)
+	{
+		source.tails[i].position = Vector(0.0f, -TAIL_SPACING * (float)(i + 1));
+		source.tails[i].oldPosition = source.tails[i].position;
+	}
+
+	SnapshotPool pool(64);
+	static GameState whole;
+	uint64_t checksum = 0;
+
+	double pooled = ClonesPerSecond(iterations, [&](uint64_t i) {
+		GameState* fork = pool.Fork(source);
+		checksum += fork->tailCount + (uint64_t)fork->tails[i % segments].position.y;
+		pool.Release(fork);
+	});
+
+	double assigned = ClonesPerSecond(iterations, [&](uint64_t i) {
+		whole = source;
+		checksum += whole.tailCount + (uint64_t)whole.tails[i % segments].position.y;
+	});
+
+	double stepped = ClonesPerSecond(iterations / 10, [&](uint64_t) {
+		GameState* fork = pool.Fork(source);
+		StepGame(*fork, 16);
+		checksum += fork->score;
+		pool.Release(fork);
+	});
+
+	std::cout << "segments=" << segments << " stateBytes=" << sizeof(GameState)
+		<< " copiedBytes=" << offsetof(GameState, tails) + segments * sizeof(Segment) << std::endl;
+	std::cout << "pool fork+release:\t" << pooled << " clones/s" << std::endl;
+	std::cout << "full assignment:\t" << assigned << " clones/s" << std::endl;
+	std::cout << "fork+step+release:\t" << stepped << " clones/s" << std::endl;
+	std::cout << "(checksum " << checksum << ")" << std::endl;
+	return EXIT_SUCCESS;
+}
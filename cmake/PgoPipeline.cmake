@@ -0,0 +1,191 @@
+# **********************************************************************************************
+#	PGO/LTO pipeline
+#	Usage: cmake [-DWORK_DIR=dir] [-DGENERATOR=name] [-DCXX_COMPILER=path] [-DROUNDS=N] [-DHELDOUT_SEED=N]
+#	             -P cmake/PgoPipeline.cmake
+# **********************************************************************************************
+#	1. Builds a plain Release tree as the baseline.
+#	2. Builds an instrumented tree (SNAKE_PGO=GENERATE).
+#	3. Trains it on the recorded sessions in replays/, headless: the game plays them through
+#	   its benchmark mode with the null renderer, and ReplayPlayback plays them through
+#	   GameState.
+#	4. Reconfigures the same tree with SNAKE_PGO=USE and SNAKE_LTO=ON and rebuilds it.
+#	5. Runs the gameplay benchmark on both builds, the best of ROUNDS runs each, and prints the
+#	   ticks per second of every workload with the speedup.
+#
+#	The gameplay benchmark is the game's --benchmark=all with the null renderer, which the
+#	training never runs. Without SDL2 and GLEW there is no game target, and ReplayPlayback
+#	stands in for it on held-out sessions: RecordReplays records them from HELDOUT_SEED, a
+#	seed the training set in replays/ was not recorded from, so no build is timed on a
+#	workload it was trained on.
+
+cmake_minimum_required(VERSION 3.19)
+
+if(NOT SOURCE_DIR)
+	get_filename_component(SOURCE_DIR "${CMAKE_CURRENT_LIST_DIR}/.." ABSOLUTE)
+endif()
+if(NOT WORK_DIR)
+	set(WORK_DIR "${SOURCE_DIR}/build-pgo")
+endif()
+if(NOT ROUNDS)
+	set(ROUNDS 5)
+endif()
+if(NOT HELDOUT_SEED)
+	set(HELDOUT_SEED 1001)
+endif()
+
+set(BASELINE_DIR "${WORK_DIR}/baseline")
+set(PGO_DIR "${WORK_DIR}/optimized")
+set(PROFILE_DIR "${WORK_DIR}/profile")
+set(HELDOUT_DIR "${WORK_DIR}/heldout")
+
+set(configureArgs -DCMAKE_BUILD_TYPE=Release)
+if(GENERATOR)
+	list(APPEND configureArgs -G "${GENERATOR}")
+endif()
+if(CXX_COMPILER)
+	list(APPEND configureArgs "-DCMAKE_CXX_COMPILER=${CXX_COMPILER}")
+endif()
+
+file(GLOB replays "${SOURCE_DIR}/replays/*.replay")
+if(NOT replays)
+	message(FATAL_ERROR "No replays in ${SOURCE_DIR}/replays; generate them with RecordReplays")
+endif()
+list(JOIN replays "," replayList)
+
+function(Step text)
+	message(STATUS "")
+	message(STATUS "==== ${text}")
+endfunction()
+
+function(Build dir)
+	execute_process(COMMAND "${CMAKE_COMMAND}" -S "${SOURCE_DIR}" -B "${dir}" ${configureArgs} ${ARGN} COMMAND_ERROR_IS_FATAL ANY)
+	execute_process(COMMAND "${CMAKE_COMMAND}" --build "${dir}" --config Release COMMAND_ERROR_IS_FATAL ANY)
+endfunction()
+
+# Integer part of a printed double such as 2.75554e+07 or 1234.5
+function(ToInteger value out)
+	if(NOT value MATCHES "^([0-9]+)\\.?([0-9]*)[eE]?([+-]?)0*([0-9]*)$")
+		set(${out} 0 PARENT_SCOPE)
+		return()
+	endif()
+	set(whole "${CMAKE_MATCH_1}")
+	set(fraction "${CMAKE_MATCH_2}")
+	set(exponent "${CMAKE_MATCH_4}")
+	if(CMAKE_MATCH_3 STREQUAL "-")
+		set(${out} 0 PARENT_SCOPE)
+		return()
+	endif()
+	if(exponent STREQUAL "")
+		set(exponent 0)
+	endif()
+	string(LENGTH "${fraction}" fractionLength)
+	while(fractionLength LESS exponent)
+		string(APPEND fraction "0")
+		math(EXPR fractionLength "${fractionLength} + 1")
+	endwhile()
+	string(SUBSTRING "${fraction}" 0 ${exponent} shifted)
+	math(EXPR result "${whole}${shifted}")
+	set(${out} ${result} PARENT_SCOPE)
+endfunction()
+
+# Best ticks per second of every "[Bench] name (...) ... ticks/s N" line over ROUNDS runs.
+# Sets <prefix>_names and <prefix>_<name> in the caller.
+function(Measure prefix)
+	set(names "")
+	foreach(round RANGE 1 ${ROUNDS})
+		execute_process(COMMAND ${ARGN} WORKING_DIRECTORY "${runDir}" OUTPUT_VARIABLE output COMMAND_ERROR_IS_FATAL ANY)
+		string(REGEX MATCHALL "\\[Bench\\] [^\n]*ticks/s [0-9.eE+-]+" lines "${output}")
+		foreach(line ${lines})
+			string(REGEX MATCH "^\\[Bench\\] ([^ :]+)" _ "${line}")
+			set(name "${CMAKE_MATCH_1}")
+			string(REGEX MATCH "ticks/s ([0-9.eE+-]+)$" _ "${line}")
+			ToInteger("${CMAKE_MATCH_1}" ticks)
+			if(NOT name IN_LIST names)
+				list(APPEND names ${name})
+				set(best_${name} 0)
+			endif()
+			if(ticks GREATER best_${name})
+				set(best_${name} ${ticks})
+			endif()
+		endforeach()
+	endforeach()
+	set(${prefix}_names ${names} PARENT_SCOPE)
+	foreach(name ${names})
+		set(${prefix}_${name} ${best_${name}} PARENT_SCOPE)
+	endforeach()
+endfunction()
+
+Step("1/5 Baseline Release build")
+Build("${BASELINE_DIR}" -DSNAKE_PGO=OFF -DSNAKE_LTO=OFF)
+
+Step("2/5 Instrumented build")
+file(REMOVE_RECURSE "${PROFILE_DIR}")
+Build("${PGO_DIR}" -DSNAKE_PGO=GENERATE -DSNAKE_LTO=OFF "-DSNAKE_PGO_DIR=${PROFILE_DIR}")
+set(hasGame OFF)
+if(EXISTS "${PGO_DIR}/bin/Snake" OR EXISTS "${PGO_DIR}/bin/Snake.exe")
+	set(hasGame ON)
+endif()
+
+Step("3/5 Training on ${replayList}")
+set(runDir "${PGO_DIR}/bin")
+if(hasGame)
+	execute_process(COMMAND "${runDir}/Snake" "--replay=${replayList}" --bench-renderer=null
+		WORKING_DIRECTORY "${runDir}" COMMAND_ERROR_IS_FATAL ANY)
+else()
+	message(STATUS "No Snake target (SDL2 or GLEW missing): training on ReplayPlayback only")
+endif()
+execute_process(COMMAND "${runDir}/ReplayPlayback" --rounds=20 ${replays} WORKING_DIRECTORY "${runDir}" COMMAND_ERROR_IS_FATAL ANY)
+
+file(GLOB profraws "${PROFILE_DIR}/*.profraw")
+if(profraws)
+	find_program(LLVM_PROFDATA NAMES llvm-profdata REQUIRED)
+	execute_process(COMMAND "${LLVM_PROFDATA}" merge "-output=${PROFILE_DIR}/snake.profdata" ${profraws} COMMAND_ERROR_IS_FATAL ANY)
+endif()
+
+Step("4/5 PGO + LTO build")
+Build("${PGO_DIR}" -DSNAKE_PGO=USE -DSNAKE_LTO=ON "-DSNAKE_PGO_DIR=${PROFILE_DIR}")
+
+Step("5/5 Gameplay benchmark, best of ${ROUNDS}")
+if(NOT hasGame)
+	file(REMOVE_RECURSE "${HELDOUT_DIR}")
+	file(MAKE_DIRECTORY "${HELDOUT_DIR}")
+	execute_process(COMMAND "${BASELINE_DIR}/bin/RecordReplays" "--out=${HELDOUT_DIR}" --count=3 --seed=${HELDOUT_SEED}
+		WORKING_DIRECTORY "${BASELINE_DIR}/bin" COMMAND_ERROR_IS_FATAL ANY)
+	file(GLOB heldout "${HELDOUT_DIR}/*.replay")
+	message(STATUS "No Snake target: timing ReplayPlayback on sessions recorded from seed ${HELDOUT_SEED}")
+endif()
+foreach(build BASELINE PGO)
+	set(runDir "${${build}_DIR}/bin")
+	if(hasGame)
+		Measure(${build} "${runDir}/Snake" --benchmark=all --bench-renderer=null)
+	else()
+		Measure(${build} "${runDir}/ReplayPlayback" ${heldout})
+	endif()
+endforeach()
+
+message(STATUS "")
+message(STATUS "ticks/s                     baseline    PGO+LTO    speedup")
+foreach(name ${BASELINE_names})
+	if(NOT DEFINED PGO_${name} OR BASELINE_${name} EQUAL 0)
+		continue()
+	endif()
+	math(EXPR permille "${PGO_${name}} * 1000 / ${BASELINE_${name}}")
+	math(EXPR whole "${permille} / 1000")
+	math(EXPR fraction "${permille} % 1000")
+	string(LENGTH "${fraction}" fractionLength)
+	while(fractionLength LESS 3)
+		string(PREPEND fraction "0")
+		math(EXPR fractionLength "${fractionLength} + 1")
+	endwhile()
+	set(row "${name}                         ")
+	string(SUBSTRING "${row}" 0 24 row)
+	set(baselineText "           ${BASELINE_${name}}")
+	string(LENGTH "${baselineText}" length)
+	math(EXPR start "${length} - 12")
+	string(SUBSTRING "${baselineText}" ${start} 12 baselineText)
+	set(pgoText "           ${PGO_${name}}")
+	string(LENGTH "${pgoText}" length)
+	math(EXPR start "${length} - 11")
+	string(SUBSTRING "${pgoText}" ${start} 11 pgoText)
+	message(STATUS "${row}${baselineText}${pgoText}    ${whole}.${fraction}x")
+endforeach()
@@ -0,0 +1,383 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <ostream>
+#include "LatencyStats.h"
+#if !defined(_WIN32)
+#include <cxxabi.h>
+#include <dlfcn.h>
+#endif
+
+// **********************************************************************************************
+//	Allocation Tracker
+// **********************************************************************************************
+//	Building with SNAKE_TRACK_ALLOCS replaces the global operator new and delete and, on glibc,
+//	malloc, calloc, realloc and free, and counts every allocation with its size. Without the
+//	flag nothing is replaced and every count stays zero.
+//
+//	One thread (the game thread) brackets its work with BeginFrame and EndFrame. Allocations it
+//	makes inside a frame are counted per frame and per call site, the return address of the
+//	allocating call. A site is resolved to a symbol when the executable exports it (-rdynamic);
+//	otherwise it prints as module+offset for addr2line. Allocator wrappers such as
+//	std::allocator show up as the site unless they are inlined, so build with -O2.
+//
+//	The replacements may only be defined once per program: include this header from one
+//	translation unit. aligned operator new, posix_memalign and aligned_alloc are not counted.
+
+struct AllocCounts
+{
+	uint64_t allocs;
+	uint64_t bytes;
+	uint64_t frees;
+};
+
+#if defined(SNAKE_TRACK_ALLOCS)
+const bool ALLOC_TRACKING = true;
+#else
+const bool ALLOC_TRACKING = false;
+#endif
+
+class AllocTracker
+{
+public:
+	static const int MAX_SITES = 1024;
+
+	static AllocTracker& Get()
+	{
+		static AllocTracker tracker;
+		return tracker;
+	}
+
+	// Called by the replaced allocation functions on any thread; never allocates or locks
+	void Allocated(size_t size, void* site)
+	{
+		allocs.fetch_add(1, std::memory_order_relaxed);
+		bytes.fetch_add(size, std::memory_order_relaxed);
+		LocalFrame& frame = Local();
+		if (!frame.open)
+			return;
+		frame.counts.allocs++;
+		frame.counts.bytes += size;
+		RecordSite(site, size);
+	}
+
+	void Freed()
+	{
+		frees.fetch_add(1, std::memory_order_relaxed);
+		LocalFrame& frame = Local();
+		if (frame.open)
+			frame.counts.frees++;
+	}
+
+	// Starts counting the calling thread's allocations as one frame
+	void BeginFrame()
+	{
+		LocalFrame& frame = Local();
+		frame.counts = AllocCounts();
+		frame.open = true;
+	}
+
+	// Closes the frame opened on the calling thread
+	void EndFrame()
+	{
+		LocalFrame& frame = Local();
+		if (!frame.open)
+			return;
+		frame.open = false;
+		lastFrame = frame.counts;
+		frameAllocs.Record((double)lastFrame.allocs);
+		frames++;
+		if (lastFrame.allocs > 0)
+			allocatingFrames++;
+	}
+
+	// Forgets the frame statistics and call sites, e.g. when a warm-up ends
+	void ResetFrames()
+	{
+		frameAllocs = LatencyStats();
+		frames = 0;
+		allocatingFrames = 0;
+		lastFrame = AllocCounts();
+		for (Site& site : sites)
+		{
+			site.count.store(0, std::memory_order_relaxed);
+			site.bytes.store(0, std::memory_order_relaxed);
+		}
+		otherSites.store(0, std::memory_order_relaxed);
+	}
+
+	[[nodiscard]] const AllocCounts& LastFrame() const
+	{
+		return lastFrame;
+	}
+
+	// Frames since the last reset that allocated at all
+	[[nodiscard]] uint64_t AllocatingFrames() const
+	{
+		return allocatingFrames;
+	}
+
+	[[nodiscard]] uint64_t Frames() const
+	{
+		return frames;
+	}
+
+	// Every thread, since the program started
+	[[nodiscard]] AllocCounts Totals() const
+	{
+		return {allocs.load(std::memory_order_relaxed), bytes.load(std::memory_order_relaxed), frees.load(std::memory_order_relaxed)};
+	}
+
+	void Report(std::ostream& out, int topSites = 10) const
+	{
+		AllocCounts totals = Totals();
+		out << "[Alloc] total allocations " << totals.allocs << "  bytes " << totals.bytes << "  frees " << totals.frees << "\n";
+		out << "[Alloc] frames " << frames << "  frames that allocated " << allocatingFrames << "\n";
+		out << "[Alloc] ";
+		frameAllocs.Report(out, "per frame", "allocs");
+
+		// Busiest sites by count; a selection pass keeps the report itself allocation free
+		bool shown[MAX_SITES] = {};
+		for (int rank = 0; rank < topSites; rank++)
+		{
+			int best = -1;
+			for (int i = 0; i < MAX_SITES; i++)
+				if (!shown[i] && sites[i].count.load(std::memory_order_relaxed) > 0
+					&& (best < 0 || sites[i].count.load(std::memory_order_relaxed) > sites[best].count.load(std::memory_order_relaxed)))
+					best = i;
+			if (best < 0)
+				break;
+			shown[best] = true;
+			out << "[Alloc] site " << sites[best].count.load(std::memory_order_relaxed) << " allocs "
+				<< sites[best].bytes.load(std::memory_order_relaxed) << " bytes at ";
+			PrintSite(out, (void*)sites[best].address.load(std::memory_order_relaxed));
+			out << "\n";
+		}
+		if (otherSites.load(std::memory_order_relaxed) > 0)
+			out << "[Alloc] " << otherSites.load(std::memory_order_relaxed) << " allocs from sites past the table\n";
+		out.flush();
+	}
+
+private:
+	struct LocalFrame
+	{
+		bool open;
+		AllocCounts counts;
+	};
+
+	struct Site
+	{
+		std::atomic<uintptr_t> address{0};
+		std::atomic<uint64_t> count{0};
+		std::atomic<uint64_t> bytes{0};
+	};
+
+	AllocTracker() = default;
+
+	// Plain thread_local data: no constructor, so touching it from inside malloc cannot recurse
+	static LocalFrame& Local()
+	{
+		static thread_local LocalFrame frame;
+		return frame;
+	}
+
+	// Open addressing on the return address; a slot is claimed once and never freed
+	void RecordSite(void* site, size_t size)
+	{
+		uintptr_t address = (uintptr_t)site;
+		size_t slot = (size_t)(((uint64_t)address * 0x9E3779B97F4A7C15ull) >> 54) & (MAX_SITES - 1);
+		for (int probe = 0; probe < MAX_SITES; probe++, slot = (slot + 1) & (MAX_SITES - 1))
+		{
+			uintptr_t current = sites[slot].address.load(std::memory_order_relaxed);
+			if (current == 0 && sites[slot].address.compare_exchange_strong(current, address, std::memory_order_relaxed))
+				current = address;
+			if (current == address)
+			{
+				sites[slot].count.fetch_add(1, std::memory_order_relaxed);
+				sites[slot].bytes.fetch_add(size, std::memory_order_relaxed);
+				return;
+			}
+		}
+		otherSites.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	static void PrintSite(std::ostream& out, void* site)
+	{
+#if !defined(_WIN32)
+		Dl_info info;
+		if (dladdr(site, &info) != 0 && info.dli_fname != nullptr)
+		{
+			if (info.dli_sname != nullptr)
+			{
+				int status = 0;
+				char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+				out << (status == 0 ? demangled : info.dli_sname) << " ";
+				std::free(demangled);
+			}
+			out << "(" << info.dli_fname << "+0x" << std::hex << ((uintptr_t)site - (uintptr_t)info.dli_fbase) << std::dec << ")";
+			return;
+		}
+#endif
+		out << site;
+	}
+
+	std::atomic<uint64_t> allocs{0};
+	std::atomic<uint64_t> bytes{0};
+	std::atomic<uint64_t> frees{0};
+	Site sites[MAX_SITES];
+	std::atomic<uint64_t> otherSites{0};
+	AllocCounts lastFrame = {};         // Frame thread
+	LatencyStats frameAllocs;
+	uint64_t frames = 0;
+	uint64_t allocatingFrames = 0;
+};
+
+// **********************************************************************************************
+//	Replaced allocation functions
+// **********************************************************************************************
+
+#if defined(SNAKE_TRACK_ALLOCS)
+
+// Everything that reads __builtin_return_address(0) stays out of line: inlined into its caller
+// it would report the caller's caller as the site.
+#define ALLOC_SITE_FUNCTION __attribute__((noinline))
+
+#if defined(__GLIBC__)
+// glibc's own entry points, so the replacements below can forward without recursing
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void* __libc_realloc(void* pointer, size_t size);
+extern "C" void __libc_free(void* pointer);
+
+extern "C" ALLOC_SITE_FUNCTION void* malloc(size_t size) noexcept
+{
+	AllocTracker::Get().Allocated(size, __builtin_return_address(0));
+	return __libc_malloc(size);
+}
+
+extern "C" ALLOC_SITE_FUNCTION void* calloc(size_t count, size_t size) noexcept
+{
+	AllocTracker::Get().Allocated(count * size, __builtin_return_address(0));
+	return __libc_calloc(count, size);
+}
+
+extern "C" ALLOC_SITE_FUNCTION void* realloc(void* pointer, size_t size) noexcept
+{
+	if (pointer != nullptr)
+		AllocTracker::Get().Freed();
+	if (size > 0)
+		AllocTracker::Get().Allocated(size, __builtin_return_address(0));
+	return __libc_realloc(pointer, size);
+}
+
+extern "C" void free(void* pointer) noexcept
+{
+	if (pointer != nullptr)
+		AllocTracker::Get().Freed();
+	__libc_free(pointer);
+}
+
+inline void* RawAllocate(size_t size)
+{
+	return __libc_malloc(size);
+}
+
+inline void RawFree(void* pointer)
+{
+	__libc_free(pointer);
+}
+#else
+inline void* RawAllocate(size_t size)
+{
+	return std::malloc(size);
+}
+
+inline void RawFree(void* pointer)
+{
+	std::free(pointer);
+}
+#endif
+
+ALLOC_SITE_FUNCTION inline void* TrackedNew(size_t size, void* site, bool throwing)
+{
+	if (size == 0)
+		size = 1;
+	AllocTracker::Get().Allocated(size, site);
+	void* pointer;
+	while ((pointer = RawAllocate(size)) == nullptr)
+	{
+		std::new_handler handler = std::get_new_handler();
+		if (handler == nullptr)
+		{
+			if (throwing)
+				throw std::bad_alloc();
+			return nullptr;
+		}
+		handler();
+	}
+	return pointer;
+}
+
+inline void TrackedDelete(void* pointer)
+{
+	if (pointer == nullptr)
+		return;
+	AllocTracker::Get().Freed();
+	RawFree(pointer);
+}
+
+ALLOC_SITE_FUNCTION void* operator new(size_t size)
+{
+	return TrackedNew(size, __builtin_return_address(0), true);
+}
+
+ALLOC_SITE_FUNCTION void* operator new[](size_t size)
+{
+	return TrackedNew(size, __builtin_return_address(0), true);
+}
+
+ALLOC_SITE_FUNCTION void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	return TrackedNew(size, __builtin_return_address(0), false);
+}
+
+ALLOC_SITE_FUNCTION void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	return TrackedNew(size, __builtin_return_address(0), false);
+}
+
+void operator delete(void* pointer) noexcept
+{
+	TrackedDelete(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+	TrackedDelete(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+	TrackedDelete(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept
+{
+	TrackedDelete(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept
+{
+	TrackedDelete(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept
+{
+	TrackedDelete(pointer);
+}
+
+#endif
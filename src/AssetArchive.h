@@ -0,0 +1,250 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+
+// **********************************************************************************************
+//	Asset Archive
+// **********************************************************************************************
+//	Every file under assets/ packed into one file (tools/PackAssets.cpp, or tools/BakeAssets.cpp
+//	with baked data added) and memory-mapped once at startup. Loaders get a pointer into the
+//	mapping, so reading an asset is a page fault, not an open/read/close and a copy.
+//
+//	Layout, native little-endian:
+//		ArchiveHeader
+//		ArchiveEntry[count]    sorted by nameHash for binary search
+//		name table             count null-terminated names, for listings and collision checks
+//		data                   each blob starts on an ARCHIVE_ALIGNMENT boundary
+//
+//	Names are paths relative to assets/ with forward slashes, e.g. "audio/carrotnom-92106.wav".
+
+const uint32_t ARCHIVE_MAGIC = 0x4B415053;     // "SPAK"
+const uint32_t ARCHIVE_VERSION = 1;
+const uint64_t ARCHIVE_ALIGNMENT = 64;
+
+struct ArchiveHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t count;
+	uint32_t namesSize;
+	uint64_t fileSize;
+};
+
+struct ArchiveEntry
+{
+	uint64_t nameHash;
+	uint64_t offset;        // From the start of the archive
+	uint64_t size;
+	uint32_t nameOffset;    // Into the name table
+	uint32_t checksum;      // FNV-1a 32 of the data, checked by Verify
+};
+
+static_assert(sizeof(ArchiveHeader) == 24, "ArchiveHeader layout is part of the file format");
+static_assert(sizeof(ArchiveEntry) == 32, "ArchiveEntry layout is part of the file format");
+
+inline uint64_t HashAssetName(const char* name)
+{
+	uint64_t hash = 0xCBF29CE484222325ull;
+	for (; *name; name++)
+		hash = (hash ^ (uint8_t)*name) * 0x100000001B3ull;
+	return hash;
+}
+
+inline uint32_t ChecksumAsset(const uint8_t* data, size_t size)
+{
+	uint32_t hash = 0x811C9DC5u;
+	for (size_t i = 0; i < size; i++)
+		hash = (hash ^ data[i]) * 0x01000193u;
+	return hash;
+}
+
+struct AssetView
+{
+	const uint8_t* data;
+	size_t size;
+};
+
+class AssetArchive
+{
+public:
+	bool Open(const char* path)
+	{
+		Close();
+		if (!file.Open(path))
+			return false;
+
+		const uint8_t* base = file.Data();
+		size_t size = file.Size();
+		if (size < sizeof(ArchiveHeader))
+			return Fail();
+		std::memcpy(&header, base, sizeof(header));
+		size_t tableEnd = sizeof(ArchiveHeader) + (size_t)header.count * sizeof(ArchiveEntry);
+		if (header.magic != ARCHIVE_MAGIC || header.version != ARCHIVE_VERSION || header.fileSize != size
+			|| tableEnd + header.namesSize > size)
+			return Fail();
+
+		entries = reinterpret_cast<const ArchiveEntry*>(base + sizeof(ArchiveHeader));
+		names = reinterpret_cast<const char*>(base + tableEnd);
+		// Find and Name read names with strcmp, so the table has to end in a terminator
+		if (header.count > 0 && (header.namesSize == 0 || names[header.namesSize - 1] != '\0'))
+			return Fail();
+		for (uint32_t i = 0; i < header.count; i++)
+		{
+			const ArchiveEntry& entry = entries[i];
+			if (entry.offset % ARCHIVE_ALIGNMENT != 0 || entry.offset > size || entry.size > size - entry.offset
+				|| entry.nameOffset >= header.namesSize || (i > 0 && entries[i - 1].nameHash >= entry.nameHash))
+				return Fail();
+		}
+		return true;
+	}
+
+	void Close()
+	{
+		file.Close();
+		entries = nullptr;
+		names = nullptr;
+		std::memset(&header, 0, sizeof(header));
+	}
+
+	// Zero-copy view of an asset, or {nullptr, 0} if it is not in the archive
+	[[nodiscard]] AssetView Find(const char* name) const
+	{
+		if (!IsOpen())
+			return {nullptr, 0};
+		uint64_t hash = HashAssetName(name);
+		const ArchiveEntry* end = entries + header.count;
+		const ArchiveEntry* entry = std::lower_bound(entries, end, hash,
+			[](const ArchiveEntry& e, uint64_t h) { return e.nameHash < h; });
+		if (entry == end || entry->nameHash != hash || std::strcmp(names + entry->nameOffset, name) != 0)
+			return {nullptr, 0};
+		return {file.Data() + entry->offset, (size_t)entry->size};
+	}
+
+	// Reads every asset and compares its checksum; touches every page, so use it in tools
+	[[nodiscard]] bool Verify() const
+	{
+		for (uint32_t i = 0; i < Count(); i++)
+			if (ChecksumAsset(file.Data() + entries[i].offset, (size_t)entries[i].size) != entries[i].checksum)
+				return false;
+		return true;
+	}
+
+	[[nodiscard]] uint32_t Count() const
+	{
+		return IsOpen() ? header.count : 0;
+	}
+
+	[[nodiscard]] const char* Name(uint32_t index) const
+	{
+		return names + entries[index].nameOffset;
+	}
+
+	[[nodiscard]] bool IsOpen() const
+	{
+		return entries != nullptr;
+	}
+
+private:
+	bool Fail()
+	{
+		Close();
+		return false;
+	}
+
+	MappedFile file;
+	ArchiveHeader header{};
+	const ArchiveEntry* entries = nullptr;
+	const char* names = nullptr;
+};
+
+// Builds an archive image in memory; PackAssets writes it out
+class ArchiveBuilder
+{
+public:
+	// False on a duplicate name or hash collision
+	bool Add(const std::string& name, std::vector<uint8_t> data)
+	{
+		uint64_t hash = HashAssetName(name.c_str());
+		for (const Item& item : items)
+			if (item.hash == hash)
+				return false;
+		items.push_back({name, hash, std::move(data)});
+		return true;
+	}
+
+	[[nodiscard]] std::vector<uint8_t> Build() const
+	{
+		std::vector<const Item*> sorted;
+		for (const Item& item : items)
+			sorted.push_back(&item);
+		std::sort(sorted.begin(), sorted.end(), [](const Item* a, const Item* b) { return a->hash < b->hash; });
+
+		std::string nameTable;
+		std::vector<ArchiveEntry> table(sorted.size());
+		for (size_t i = 0; i < sorted.size(); i++)
+		{
+			table[i].nameHash = sorted[i]->hash;
+			table[i].nameOffset = (uint32_t)nameTable.size();
+			table[i].size = sorted[i]->data.size();
+			table[i].checksum = ChecksumAsset(sorted[i]->data.data(), sorted[i]->data.size());
+			nameTable += sorted[i]->name;
+			nameTable += '\0';
+		}
+
+		uint64_t offset = sizeof(ArchiveHeader) + table.size() * sizeof(ArchiveEntry) + nameTable.size();
+		for (size_t i = 0; i < sorted.size(); i++)
+		{
+			offset = (offset + ARCHIVE_ALIGNMENT - 1) / ARCHIVE_ALIGNMENT * ARCHIVE_ALIGNMENT;
+			table[i].offset = offset;
+			offset += table[i].size;
+		}
+
+		ArchiveHeader header = {ARCHIVE_MAGIC, ARCHIVE_VERSION, (uint32_t)table.size(), (uint32_t)nameTable.size(), offset};
+		std::vector<uint8_t> image((size_t)offset, 0);
+		std::memcpy(image.data(), &header, sizeof(header));
+		if (!table.empty())
+			std::memcpy(image.data() + sizeof(header), table.data(), table.size() * sizeof(ArchiveEntry));
+		std::memcpy(image.data() + sizeof(header) + table.size() * sizeof(ArchiveEntry), nameTable.data(), nameTable.size());
+		for (size_t i = 0; i < sorted.size(); i++)
+			if (!sorted[i]->data.empty())
+				std::memcpy(image.data() + table[i].offset, sorted[i]->data.data(), sorted[i]->data.size());
+		return image;
+	}
+
+	// Writes beside the target and renames, so a running game never maps a half-written archive
+	[[nodiscard]] bool Write(const std::string& path) const
+	{
+		std::vector<uint8_t> image = Build();
+		std::string temporary = path + ".tmp";
+		FILE* file = std::fopen(temporary.c_str(), "wb");
+		bool ok = file != nullptr && std::fwrite(image.data(), 1, image.size(), file) == image.size();
+		ok = file != nullptr && std::fclose(file) == 0 && ok;
+
+		// std::rename does not replace an existing file on Windows
+		std::error_code error;
+		if (ok)
+			std::filesystem::rename(temporary, path, error);
+		if (!ok || error)
+		{
+			std::remove(temporary.c_str());
+			return false;
+		}
+		return true;
+	}
+
+private:
+	struct Item
+	{
+		std::string name;
+		uint64_t hash;
+		std::vector<uint8_t> data;
+	};
+
+	std::vector<Item> items;
+};
@@ -0,0 +1,177 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// **********************************************************************************************
+//	Asset Watcher
+// **********************************************************************************************
+//	Watches asset directories with inotify on a background thread and queues the names of files
+//	that were written or moved into place. The game drains the queue once per frame with
+//	TakeChanges and reloads between frames, so nothing is swapped while a frame is drawn. A file
+//	saved several times before the next frame is reported once.
+//
+//	Editors that save through a temporary file and a rename show up as a move, archive tools
+//	(ArchiveBuilder::Write) the same way. Only Linux has inotify; elsewhere Start fails and the
+//	game runs without hot reload.
+
+struct WatchRoot
+{
+	std::string directory;
+	bool recursive;         // Also watch subdirectories, including ones created later
+};
+
+struct AssetChange
+{
+	int root;               // Index into the roots given to Start
+	std::string name;       // Relative to the root, forward slashes
+};
+
+class AssetWatcher
+{
+public:
+	AssetWatcher() = default;
+	AssetWatcher(const AssetWatcher&) = delete;
+	AssetWatcher& operator=(const AssetWatcher&) = delete;
+
+	~AssetWatcher()
+	{
+		Stop();
+	}
+
+	// False when no root could be watched
+	bool Start(const std::vector<WatchRoot>& watchRoots)
+	{
+		Stop();
+#if defined(__linux__)
+		descriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (descriptor < 0)
+			return false;
+		roots = watchRoots;
+		for (int i = 0; i < (int)roots.size(); i++)
+			AddDirectory(i, roots[i].directory, "");
+		if (watches.empty())
+		{
+			Stop();
+			return false;
+		}
+		running.store(true, std::memory_order_release);
+		thread = std::thread(&AssetWatcher::Run, this);
+		return true;
+#else
+		(void)watchRoots;
+		return false;
+#endif
+	}
+
+	void Stop()
+	{
+		running.store(false, std::memory_order_release);
+		if (thread.joinable())
+			thread.join();
+#if defined(__linux__)
+		if (descriptor >= 0)
+			close(descriptor);
+#endif
+		descriptor = -1;
+		watches.clear();
+	}
+
+	// Everything that changed since the last call, each file once
+	[[nodiscard]] std::vector<AssetChange> TakeChanges()
+	{
+		std::vector<AssetChange> changes;
+		std::lock_guard<std::mutex> lock(mutex);
+		changes.swap(pending);
+		return changes;
+	}
+
+	[[nodiscard]] bool IsRunning() const
+	{
+		return running.load(std::memory_order_acquire);
+	}
+
+private:
+	struct Watch
+	{
+		int descriptor;
+		int root;
+		std::string prefix;     // Directory relative to the root, with a trailing slash
+	};
+
+#if defined(__linux__)
+	void AddDirectory(int root, const std::string& path, const std::string& prefix)
+	{
+		int watch = inotify_add_watch(descriptor, path.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ONLYDIR);
+		if (watch < 0)
+			return;
+		watches.push_back({watch, root, prefix});
+		if (!roots[root].recursive)
+			return;
+
+		std::error_code error;
+		for (const auto& entry : std::filesystem::directory_iterator(path, error))
+			if (entry.is_directory(error))
+				AddDirectory(root, entry.path().string(), prefix + entry.path().filename().string() + "/");
+	}
+
+	void Run()
+	{
+		alignas(inotify_event) char buffer[4096];
+		pollfd request = {descriptor, POLLIN, 0};
+		while (running.load(std::memory_order_acquire))
+		{
+			// The timeout bounds how long Stop waits for the thread
+			if (poll(&request, 1, 100) <= 0)
+				continue;
+			ssize_t length = read(descriptor, buffer, sizeof(buffer));
+			for (ssize_t offset = 0; offset < length;)
+			{
+				const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+				offset += (ssize_t)(sizeof(inotify_event) + event->len);
+				if (event->len == 0)
+					continue;
+				auto watch = std::find_if(watches.begin(), watches.end(), [&](const Watch& w) { return w.descriptor == event->wd; });
+				if (watch == watches.end())
+					continue;
+
+				int root = watch->root;
+				std::string name = watch->prefix + event->name;
+				if (event->mask & IN_ISDIR)
+				{
+					if (event->mask & (IN_CREATE | IN_MOVED_TO))
+						AddDirectory(root, roots[root].directory + "/" + name, name + "/");
+				}
+				else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+					Queue(root, name);
+			}
+		}
+	}
+#endif
+
+	void Queue(int root, const std::string& name)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (const AssetChange& change : pending)
+			if (change.root == root && change.name == name)
+				return;
+		pending.push_back({root, name});
+	}
+
+	std::vector<WatchRoot> roots;
+	std::vector<Watch> watches;         // Watcher thread only once started
+	std::mutex mutex;
+	std::vector<AssetChange> pending;
+	std::atomic<bool> running{false};
+	std::thread thread;
+	int descriptor = -1;
+};
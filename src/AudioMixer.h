@@ -0,0 +1,308 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include <SDL2/SDL.h>
+#include "LatencyStats.h"
+#include "MixKernels.h"
+#include "SpscQueue.h"
+
+// **********************************************************************************************
+//	Audio Mixer
+// **********************************************************************************************
+//	Runs inside the SDL audio callback and mixes a fixed pool of voices into the device buffer.
+//	The game thread never takes the audio lock: Play and Stop push a command onto a lock-free
+//	SPSC queue that the callback drains at the start of every buffer.
+//
+//	Clips must already be in the device format (signed 16-bit, interleaved, device channel
+//	count); LoadAudio converts them into the SamplePool once. Register every clip before the device
+//	is unpaused, the clip table is read by the audio thread without a lock.
+//
+//	A voice can play at a different pitch: it is resampled on the fly with the linear kernel
+//	into a scratch buffer before being accumulated. The sample loops run through MixKernels(),
+//	the best SIMD level for this CPU.
+//
+//	Every command carries the time it was triggered. The callback that first outputs a sound
+//	records trigger-to-callback latency, and a callback arriving much later than one buffer
+//	period after the previous one counts as an underrun (the device ran dry in between).
+
+const int MAX_VOICES = 16;
+
+// Streams are mixed in slot order, each with its own gain
+enum eStreamSlot {STREAM_MUSIC = 0, STREAM_SYNTH, STREAM_SLOTS};
+
+// Continuous source mixed under the voices, e.g. streamed music or the synthesizer. Read runs on the audio thread
+// and must fill all samples, padding with silence.
+class StreamSource
+{
+public:
+	virtual ~StreamSource() = default;
+	virtual int Read(Sint16* out, int samples) = 0;
+};
+
+class AudioMixer
+{
+public:
+	typedef uint32_t VoiceHandle;
+
+	// Call before the device starts; returns the clip id used by Play
+	int AddClip(const Sint16* samples, Uint32 frames)
+	{
+		clips.push_back({samples, frames});
+		return (int)clips.size() - 1;
+	}
+
+	// Points a clip at new samples, e.g. after a hot reload. Call with the device locked
+	// (SDL_LockAudioDevice); voices still playing the old samples are cut.
+	void ReplaceClip(int clip, const Sint16* samples, Uint32 frames)
+	{
+		clips[clip] = {samples, frames};
+		for (Voice& voice : voices)
+			if (voice.handle != 0 && voice.clip == clip)
+				voice.handle = 0;
+	}
+
+	// Call before the device starts with the obtained buffer size and rate. Sizes the scratch
+	// buffers once; Mix never grows them.
+	void SetFormat(int channelCount, int bufferFrames, int frequency)
+	{
+		channels = std::max(1, channelCount);
+		blockFrames = std::max(bufferFrames, 4096);
+		accumulator.assign((size_t)blockFrames * channels, 0);
+		streamBuffer.assign(accumulator.size(), 0);
+		pitchBuffer.assign(accumulator.size(), 0);
+		periodMs = 1000.0 * bufferFrames / std::max(1, frequency);
+	}
+
+	// O(1), never blocks. Returns 0 if the command queue was full. pitch is a playback speed
+	// multiplier between 0.25 and 4.
+	VoiceHandle Play(int clip, float gain = 1.0f, float pitch = 1.0f)
+	{
+		VoiceHandle handle = nextHandle++;
+		if (handle == 0)
+			handle = nextHandle++;
+		if (!commands.Push({Command::PLAY, clip, handle, gain, pitch, Now()}))
+		{
+			droppedCommands.fetch_add(1, std::memory_order_relaxed);
+			return 0;
+		}
+		return handle;
+	}
+
+	void Stop(VoiceHandle handle)
+	{
+		if (!commands.Push({Command::STOP, -1, handle, 0.0f, 1.0f, Now()}))
+			droppedCommands.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void StopAll()
+	{
+		if (!commands.Push({Command::STOP_ALL, -1, 0, 0.0f, 1.0f, Now()}))
+			droppedCommands.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// Takes effect at the next callback; pass nullptr before destroying the stream
+	void SetStream(eStreamSlot slot, StreamSource* stream, float gain)
+	{
+		streamGain[slot].store((int32_t)(std::clamp(gain, 0.0f, 1.0f) * 32767.0f), std::memory_order_relaxed);
+		streams[slot].store(stream, std::memory_order_release);
+	}
+
+	void SetMusic(StreamSource* stream, float gain = 0.6f)
+	{
+		SetStream(STREAM_MUSIC, stream, gain);
+	}
+
+	// Audio thread: fills frames interleaved frames of signed 16-bit output
+	void Mix(Sint16* out, int frames)
+	{
+		int64_t now = Now();
+		if (lastCallback != 0 && (double)(now - lastCallback) / 1e6 > periodMs * 1.5)
+			underruns.fetch_add(1, std::memory_order_relaxed);
+		lastCallback = now;
+
+		ApplyCommands(now);
+
+		// A callback longer than the buffers SetFormat sized is mixed in blocks, so the audio
+		// thread never allocates. A zero-frame call still runs one block to count the voices.
+		int active = 0;
+		do
+		{
+			int block = std::min(frames, blockFrames);
+			active = MixBlock(out, block);
+			out += (size_t)block * channels;
+			frames -= block;
+		} while (frames > 0);
+
+		activeVoices.store(active, std::memory_order_relaxed);
+		callbackMs.Record((double)(Now() - now) / 1e6);
+	}
+
+	static void SDLCALL Callback(void* userdata, Uint8* stream, int length)
+	{
+		AudioMixer* mixer = static_cast<AudioMixer*>(userdata);
+		mixer->Mix(reinterpret_cast<Sint16*>(stream), length / (int)(sizeof(Sint16) * mixer->channels));
+	}
+
+	[[nodiscard]] int ActiveVoices() const
+	{
+		return activeVoices.load(std::memory_order_relaxed);
+	}
+
+	[[nodiscard]] uint64_t DroppedCommands() const
+	{
+		return droppedCommands.load(std::memory_order_relaxed);
+	}
+
+	[[nodiscard]] uint64_t Underruns() const
+	{
+		return underruns.load(std::memory_order_relaxed);
+	}
+
+	// Statistics are written by the audio thread; report after the device is closed or paused
+	void Report(std::ostream& out) const
+	{
+		out << "[Audio] buffer period ms " << periodMs << "  underruns " << Underruns()
+			<< "  dropped commands " << DroppedCommands() << "\n";
+		out << "[Audio] ";
+		triggerLatency.Report(out, "trigger to callback");
+		out << "[Audio] estimated trigger to output ms p50 " << triggerLatency.Percentile(0.50) + periodMs
+			<< " p99 " << triggerLatency.Percentile(0.99) + periodMs << "\n";
+		out << "[Audio] ";
+		callbackMs.Report(out, "callback cost");
+	}
+
+private:
+	static const uint32_t UNITY_STEP = 65536;
+
+	struct Clip
+	{
+		const Sint16* samples;
+		Uint32 frames;
+	};
+
+	struct Voice
+	{
+		VoiceHandle handle = 0;     // 0 = free
+		int clip = 0;
+		uint64_t position = 0;      // Q16.16 frames
+		uint32_t step = UNITY_STEP; // Q16.16 frames per output frame
+		int32_t gain = 0;           // Q15
+	};
+
+	struct Command
+	{
+		enum Type {PLAY, STOP, STOP_ALL} type;
+		int clip;
+		VoiceHandle handle;
+		float gain;
+		float pitch;
+		int64_t triggered;          // Steady clock nanoseconds
+	};
+
+	static int64_t Now()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	void ApplyCommands(int64_t now)
+	{
+		Command command;
+		while (commands.Pop(command))
+		{
+			if (command.type == Command::PLAY)
+			{
+				if (command.clip < 0 || command.clip >= (int)clips.size())
+					continue;
+				// Take a free voice, or steal the one closest to finishing
+				Voice* target = &voices[0];
+				for (Voice& voice : voices)
+				{
+					if (voice.handle == 0)
+					{
+						target = &voice;
+						break;
+					}
+					if (clips[voice.clip].frames - (voice.position >> 16) < clips[target->clip].frames - (target->position >> 16))
+						target = &voice;
+				}
+				target->handle = command.handle;
+				target->clip = command.clip;
+				target->position = 0;
+				target->step = (uint32_t)(std::clamp(command.pitch, 0.25f, 4.0f) * UNITY_STEP);
+				target->gain = (int32_t)(std::clamp(command.gain, 0.0f, 1.0f) * 32767.0f);
+				triggerLatency.Record((double)(now - command.triggered) / 1e6);
+			}
+			else
+			{
+				for (Voice& voice : voices)
+					if (command.type == Command::STOP_ALL || voice.handle == command.handle)
+						voice.handle = 0;
+			}
+		}
+	}
+
+	// At most blockFrames frames; returns the voices that played
+	int MixBlock(Sint16* out, int frames)
+	{
+		int samples = frames * channels;
+		std::fill(accumulator.begin(), accumulator.begin() + samples, 0);
+
+		for (int slot = 0; slot < STREAM_SLOTS; slot++)
+		{
+			StreamSource* stream = streams[slot].load(std::memory_order_acquire);
+			if (stream == nullptr)
+				continue;
+			stream->Read(streamBuffer.data(), samples);
+			kernels.mixAdd(accumulator.data(), streamBuffer.data(), samples, streamGain[slot].load(std::memory_order_relaxed));
+		}
+
+		int active = 0;
+		for (Voice& voice : voices)
+		{
+			if (voice.handle == 0)
+				continue;
+			active++;
+			const Clip& clip = clips[voice.clip];
+			if (voice.step == UNITY_STEP)
+			{
+				Uint32 position = (Uint32)(voice.position >> 16);
+				Uint32 count = std::min<Uint32>((Uint32)frames, clip.frames - position);
+				kernels.mixAdd(accumulator.data(), clip.samples + (size_t)position * channels, (size_t)count * channels, voice.gain);
+				voice.position += (uint64_t)count << 16;
+			}
+			else
+			{
+				size_t count = kernels.resampleLinear(pitchBuffer.data(), (size_t)frames, clip.samples, clip.frames,
+					channels, voice.position, voice.step);
+				kernels.mixAdd(accumulator.data(), pitchBuffer.data(), count * channels, voice.gain);
+			}
+			if ((voice.position >> 16) >= clip.frames)
+				voice.handle = 0;
+		}
+
+		kernels.saturate(out, accumulator.data(), samples);
+		return active;
+	}
+
+	std::vector<Clip> clips;
+	Voice voices[MAX_VOICES];
+	std::vector<int32_t> accumulator = std::vector<int32_t>(4096 * 2, 0);
+	std::vector<Sint16> streamBuffer = std::vector<Sint16>(4096 * 2, 0);
+	std::vector<Sint16> pitchBuffer = std::vector<Sint16>(4096 * 2, 0);
+	const MixKernelTable& kernels = MixKernels();
+	std::atomic<StreamSource*> streams[STREAM_SLOTS] = {};
+	std::atomic<int32_t> streamGain[STREAM_SLOTS] = {};
+	int channels = 2;
+	int blockFrames = 4096;             // Frames the scratch buffers hold
+	SpscQueue<Command, 64> commands;
+	VoiceHandle nextHandle = 1;
+	std::atomic<int> activeVoices{0};
+	std::atomic<uint64_t> droppedCommands{0};
+	std::atomic<uint64_t> underruns{0};
+	double periodMs = 1000.0 * 4096 / 44100;
+	int64_t lastCallback = 0;
+	LatencyStats triggerLatency, callbackMs;
+};
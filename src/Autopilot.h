@@ -0,0 +1,48 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include "GameState.h"
+#include "LatencyStats.h"
+
+// **********************************************************************************************
+//	Autopilot Interface
+// **********************************************************************************************
+//	An autopilot looks at a snapshot of the game and picks the next eDirection. main.cpp feeds
+//	that into ChangeDirection, the same path the arrow keys take in HandleInput.
+
+class Autopilot
+{
+public:
+	virtual ~Autopilot() = default;
+
+	// Picks the direction to steer in from the given state
+	virtual eDirection Decide(const GameState& state) = 0;
+
+	// Prints the decision statistics gathered so far
+	virtual void Report(std::ostream& out) const = 0;
+
+protected:
+	using Clock = std::chrono::steady_clock;
+
+	static double MillisecondsSince(Clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	// Decision latency in milliseconds
+	LatencyStats stats;
+};
+
+inline eDirection OppositeDirection(eDirection d)
+{
+	switch (d)
+	{
+		case eDirection::LEFT: return eDirection::RIGHT;
+		case eDirection::RIGHT: return eDirection::LEFT;
+		case eDirection::UP: return eDirection::DOWN;
+		case eDirection::DOWN: return eDirection::UP;
+		default: return eDirection::STOP;
+	}
+}
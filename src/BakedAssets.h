@@ -0,0 +1,119 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include "AssetArchive.h"
+
+// **********************************************************************************************
+//	Baked Asset Formats
+// **********************************************************************************************
+//	Runtime-ready data produced offline by tools/BakeAssets.cpp and stored in assets.pak next to
+//	the source files. Each blob is a fixed header followed by its payload at a 64-byte aligned
+//	offset, so the game uses it in place inside the mapped archive: no decoding, no conversion.
+//
+//	Baked names mirror the source: "audio/x.wav" bakes to "baked/audio/x.pcm" and
+//	"font/a/b.ttf" to "baked/font/a/b.atlas".
+
+const uint32_t BAKED_PCM_MAGIC = 0x4D435042;     // "BPCM"
+const uint32_t BAKED_FONT_MAGIC = 0x544E4642;    // "BFNT"
+const uint32_t BAKED_VERSION = 1;
+const uint32_t BAKED_PAYLOAD_ALIGNMENT = 64;
+
+// Signed 16-bit interleaved PCM at the rate and channel count the game asks the device for
+struct BakedPcmHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t frequency;
+	uint16_t channels;
+	uint16_t bitsPerSample;
+	uint32_t frames;
+	uint32_t dataOffset;        // From the start of the blob
+};
+
+struct GlyphMetrics
+{
+	uint16_t x, y;              // Top-left corner in the atlas
+	uint16_t width, height;
+	int16_t bearingX;           // Pen to left edge
+	int16_t bearingY;           // Baseline to top edge, up is positive
+	int16_t advance;            // Pen movement in pixels
+	int16_t reserved;
+};
+
+// 8-bit coverage atlas for the printable ASCII range
+struct FontAtlasHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint16_t pixelSize;
+	int16_t ascender;
+	int16_t descender;
+	int16_t lineHeight;
+	uint16_t atlasWidth;
+	uint16_t atlasHeight;
+	uint16_t firstChar;
+	uint16_t glyphCount;
+	uint32_t glyphOffset;       // GlyphMetrics[glyphCount], from the start of the blob
+	uint32_t pixelOffset;       // atlasWidth * atlasHeight bytes, from the start of the blob
+};
+
+static_assert(sizeof(BakedPcmHeader) == 24, "BakedPcmHeader layout is part of the file format");
+static_assert(sizeof(GlyphMetrics) == 16, "GlyphMetrics layout is part of the file format");
+static_assert(sizeof(FontAtlasHeader) == 32, "FontAtlasHeader layout is part of the file format");
+
+struct BakedPcmView
+{
+	BakedPcmHeader header;
+	const int16_t* samples;
+};
+
+struct FontAtlasView
+{
+	FontAtlasHeader header;
+	const GlyphMetrics* glyphs;
+	const uint8_t* pixels;
+
+	// nullptr for characters outside the baked range
+	[[nodiscard]] const GlyphMetrics* Glyph(char c) const
+	{
+		unsigned int index = (unsigned char)c - header.firstChar;
+		return index < header.glyphCount ? &glyphs[index] : nullptr;
+	}
+};
+
+// "audio/x.wav" -> "baked/audio/x.pcm"
+inline std::string BakedAssetName(const std::string& source, const char* extension)
+{
+	size_t dot = source.find_last_of('.');
+	return "baked/" + source.substr(0, dot) + extension;
+}
+
+inline bool ReadBakedPcm(AssetView view, BakedPcmView& out)
+{
+	if (view.data == nullptr || view.size < sizeof(BakedPcmHeader))
+		return false;
+	std::memcpy(&out.header, view.data, sizeof(BakedPcmHeader));
+	const BakedPcmHeader& h = out.header;
+	if (h.magic != BAKED_PCM_MAGIC || h.version != BAKED_VERSION || h.bitsPerSample != 16 || h.channels == 0
+		|| h.dataOffset % BAKED_PAYLOAD_ALIGNMENT != 0 || h.dataOffset > view.size
+		|| (uint64_t)h.frames * h.channels * sizeof(int16_t) > view.size - h.dataOffset)
+		return false;
+	out.samples = reinterpret_cast<const int16_t*>(view.data + h.dataOffset);
+	return true;
+}
+
+inline bool ReadFontAtlas(AssetView view, FontAtlasView& out)
+{
+	if (view.data == nullptr || view.size < sizeof(FontAtlasHeader))
+		return false;
+	std::memcpy(&out.header, view.data, sizeof(FontAtlasHeader));
+	const FontAtlasHeader& h = out.header;
+	if (h.magic != BAKED_FONT_MAGIC || h.version != BAKED_VERSION || h.glyphOffset % alignof(GlyphMetrics) != 0
+		|| h.glyphOffset > view.size || (uint64_t)h.glyphCount * sizeof(GlyphMetrics) > view.size - h.glyphOffset
+		|| h.pixelOffset > view.size || (uint64_t)h.atlasWidth * h.atlasHeight > view.size - h.pixelOffset)
+		return false;
+	out.glyphs = reinterpret_cast<const GlyphMetrics*>(view.data + h.glyphOffset);
+	out.pixels = view.data + h.pixelOffset;
+	return true;
+}
@@ -0,0 +1,211 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <SDL2/SDL.h>
+#include "AudioMixer.h"
+#include "SpscQueue.h"
+
+// **********************************************************************************************
+//	Chiptune Synthesizer
+// **********************************************************************************************
+//	Generates the sound effects in the audio callback instead of playing recorded clips. A
+//	sound is a SynthPatch of a dozen bytes: one oscillator (pulse, triangle, saw or noise), a
+//	linear frequency sweep, optional arpeggio steps and an attack/hold/release envelope. The
+//	game thread queues Trigger commands on a lock-free SPSC queue like AudioMixer::Play; the
+//	synth is mixed as a StreamSource in the STREAM_SYNTH slot.
+//
+//	Everything runs in integer arithmetic on a 32-bit phase accumulator, so a given sequence
+//	of triggers always renders the same samples.
+
+enum eWaveform : uint8_t {WAVE_PULSE = 0, WAVE_TRIANGLE, WAVE_SAW, WAVE_NOISE};
+
+struct SynthPatch
+{
+	eWaveform waveform;
+	uint8_t duty;               // Pulse width out of 256
+	uint8_t volume;             // Out of 255
+	int8_t stepSemitones;       // Pitch change per arpeggio step
+	uint8_t steps;              // Arpeggio steps over the hold and release, 0 for none
+	uint8_t attackMs;
+	uint16_t startHz;
+	uint16_t endHz;             // Swept linearly over the whole sound
+	uint16_t holdMs;
+	uint16_t releaseMs;
+};
+
+// Rising blip for eating a fruit
+const SynthPatch EAT_PATCH = {WAVE_PULSE, 128, 150, 0, 0, 2, 660, 1320, 40, 60};
+// Three falling notes for game over
+const SynthPatch GAME_OVER_PATCH = {WAVE_PULSE, 64, 170, -4, 2, 5, 392, 330, 450, 450};
+
+class ChipSynth : public StreamSource
+{
+public:
+	static const int MAX_SYNTH_VOICES = 4;
+
+	// Call before the device starts
+	void SetFormat(int channelCount, int frequency)
+	{
+		channels = std::max(1, channelCount);
+		rate = std::max(1, frequency);
+	}
+
+	// O(1), never blocks. pitch multiplies every frequency in the patch.
+	bool Trigger(const SynthPatch& patch, float pitch = 1.0f)
+	{
+		if (!commands.Push({patch, pitch}))
+		{
+			droppedCommands.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		return true;
+	}
+
+	// Audio thread
+	int Read(Sint16* out, int samples) override
+	{
+		ApplyCommands();
+		int frames = samples / channels;
+		for (int f = 0; f < frames; f++)
+		{
+			int32_t sum = 0;
+			for (Voice& voice : voices)
+				if (voice.remaining > 0)
+					sum += NextSample(voice);
+			Sint16 sample = (Sint16)std::clamp(sum, -32768, 32767);
+			for (int c = 0; c < channels; c++)
+				out[f * channels + c] = sample;
+		}
+		std::fill(out + frames * channels, out + samples, (Sint16)0);
+		return samples;
+	}
+
+	[[nodiscard]] uint64_t DroppedCommands() const
+	{
+		return droppedCommands.load(std::memory_order_relaxed);
+	}
+
+	// Everything the synth needs to make its sounds; there is no sample data
+	[[nodiscard]] static size_t FootprintBytes()
+	{
+		return sizeof(ChipSynth) + 2 * sizeof(SynthPatch);
+	}
+
+private:
+	struct Command
+	{
+		SynthPatch patch;
+		float pitch;
+	};
+
+	struct Voice
+	{
+		eWaveform waveform = WAVE_PULSE;
+		uint32_t duty = 0;              // Phase threshold for the pulse wave
+		uint32_t phase = 0;
+		int64_t increment = 0;          // Phase step per sample, Q32 of a cycle in the high 32 bits
+		int64_t sweep = 0;              // Added to increment every sample
+		uint32_t stepLength = 0, stepCounter = 0;
+		uint32_t stepRatio = 65536;     // Q16 multiplier applied at each arpeggio step
+		uint32_t attack = 0, hold = 0, release = 0, elapsed = 0, remaining = 0;
+		int32_t volume = 0;             // Q15
+		uint16_t noise = 1;             // 15-bit LFSR
+	};
+
+	int32_t NextSample(Voice& voice)
+	{
+		// Envelope: linear attack, full level hold, linear release
+		int32_t envelope = 32767;
+		if (voice.elapsed < voice.attack)
+			envelope = (int32_t)((int64_t)32767 * voice.elapsed / voice.attack);
+		else if (voice.elapsed >= voice.attack + voice.hold)
+			envelope = (int32_t)((int64_t)32767 * voice.remaining / std::max(1u, voice.release));
+
+		uint32_t previous = voice.phase;
+		voice.phase += (uint32_t)(voice.increment >> 32);
+		int32_t wave;
+		switch (voice.waveform)
+		{
+			case WAVE_TRIANGLE:
+				wave = (int32_t)(voice.phase >> 15) - 65536;
+				wave = (wave < 0 ? -wave : wave) - 32768;
+				break;
+			case WAVE_SAW:
+				wave = (int32_t)(voice.phase >> 16) - 32768;
+				break;
+			case WAVE_NOISE:
+				// Clock the LFSR once per oscillator cycle, like the NES noise channel
+				if (voice.phase < previous)
+					voice.noise = (uint16_t)((voice.noise >> 1) | ((((voice.noise >> 0) ^ (voice.noise >> 1)) & 1) << 14));
+				wave = (voice.noise & 1) ? 32767 : -32768;
+				break;
+			default:
+				wave = voice.phase < voice.duty ? 32767 : -32768;
+				break;
+		}
+
+		voice.increment = std::max<int64_t>(voice.increment + voice.sweep, 0);
+		if (voice.stepLength != 0 && ++voice.stepCounter >= voice.stepLength)
+		{
+			voice.stepCounter = 0;
+			voice.increment = (voice.increment >> 16) * voice.stepRatio;
+			voice.sweep = (voice.sweep >> 16) * (int64_t)voice.stepRatio;
+		}
+		voice.elapsed++;
+		voice.remaining--;
+
+		int32_t level = (int32_t)(((int64_t)envelope * voice.volume) >> 15);
+		return (wave * level) >> 15;
+	}
+
+	void ApplyCommands()
+	{
+		Command command;
+		while (commands.Pop(command))
+		{
+			const SynthPatch& patch = command.patch;
+			// Take a free voice, or the one closest to finishing
+			Voice* voice = &voices[0];
+			for (Voice& v : voices)
+			{
+				if (v.remaining == 0)
+				{
+					voice = &v;
+					break;
+				}
+				if (v.remaining < voice->remaining)
+					voice = &v;
+			}
+
+			uint32_t length = (uint32_t)((uint64_t)rate * ((uint32_t)patch.attackMs + patch.holdMs + patch.releaseMs) / 1000);
+			double pitch = std::clamp((double)command.pitch, 0.25, 4.0);
+			double nyquist = rate * 0.45;
+			double start = std::min(patch.startHz * pitch, nyquist) * 4294967296.0 / rate;
+			double end = std::min(patch.endHz * pitch, nyquist) * 4294967296.0 / rate;
+
+			*voice = Voice();
+			voice->waveform = patch.waveform;
+			voice->duty = (uint32_t)patch.duty << 24;
+			voice->increment = (int64_t)(start * 4294967296.0);
+			voice->sweep = length > 0 ? (int64_t)((end - start) * 4294967296.0 / length) : 0;
+			voice->attack = (uint32_t)((uint64_t)rate * patch.attackMs / 1000);
+			voice->hold = (uint32_t)((uint64_t)rate * patch.holdMs / 1000);
+			voice->release = (uint32_t)((uint64_t)rate * patch.releaseMs / 1000);
+			voice->remaining = std::max(1u, length);
+			voice->volume = patch.volume * 128;
+			if (patch.steps > 0)
+			{
+				voice->stepLength = std::max(1u, length / (patch.steps + 1u));
+				voice->stepRatio = (uint32_t)(std::pow(2.0, patch.stepSemitones / 12.0) * 65536.0);
+			}
+		}
+	}
+
+	Voice voices[MAX_SYNTH_VOICES];
+	SpscQueue<Command, 32> commands;
+	std::atomic<uint64_t> droppedCommands{0};
+	int channels = 2;
+	int rate = 44100;
+};
@@ -0,0 +1,176 @@
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Profiler.h"
+
+// **********************************************************************************************
+//	Chrome Trace Capture
+// **********************************************************************************************
+//	Writes every profiler event of the next N frames as Chrome trace-event JSON, one complete
+//	("X") event per scope on the thread that ran it. Open the file in chrome://tracing or
+//	ui.perfetto.dev.
+//
+//	The main thread only appends raw events to a batch as Profiler::EndFrame drains them and
+//	hands the batch over once per frame. Formatting and file I/O happen on the capture's own
+//	writer thread.
+
+class ChromeTrace
+{
+public:
+	ChromeTrace() = default;
+	ChromeTrace(const ChromeTrace&) = delete;
+	ChromeTrace& operator=(const ChromeTrace&) = delete;
+
+	~ChromeTrace()
+	{
+		Stop();
+		Wait();
+	}
+
+	// Main thread. Captures the next frames; false if a capture is running or the file cannot be created.
+	bool Start(const std::string& tracePath, int frames)
+	{
+		if (framesLeft > 0)
+			return false;
+		Wait();
+		file = std::fopen(tracePath.c_str(), "wb");
+		if (file == nullptr)
+		{
+			std::cout << "Cannot write trace " << tracePath << std::endl;
+			return false;
+		}
+		path = tracePath;
+		framesLeft = std::max(1, frames);
+		finishing = false;
+		events = 0;
+
+		Profiler& profiler = Profiler::Get();
+		profilerWasEnabled = profiler.Enabled();
+		profiler.SetEnabled(true);
+		enableCallsAtStart = profiler.EnableCalls();
+		profiler.SetEventSink([this](int thread, const ProfileEvent& event) { batch.push_back({thread, event}); });
+		writer = std::thread(&ChromeTrace::Run, this);
+		std::cout << "Tracing " << framesLeft << " frames to " << path << std::endl;
+		return true;
+	}
+
+	// Main thread, after Profiler::EndFrame
+	void EndFrame()
+	{
+		if (framesLeft == 0)
+			return;
+		Hand();
+		if (--framesLeft == 0)
+			Stop();
+	}
+
+	// Main thread. Ends the capture early; the writer finishes the file in the background.
+	void Stop()
+	{
+		if (!writer.joinable() || finishing)
+			return;
+		Profiler::Get().SetEventSink(nullptr);
+		// Someone else set the profiler during the capture, e.g. F3 turned on the overlay:
+		// their state stands
+		if (Profiler::Get().EnableCalls() == enableCallsAtStart)
+			Profiler::Get().SetEnabled(profilerWasEnabled);
+		Hand();
+		framesLeft = 0;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			finishing = true;
+		}
+		wake.notify_one();
+	}
+
+	// Blocks until the file of the last capture is complete
+	void Wait()
+	{
+		if (writer.joinable())
+			writer.join();
+	}
+
+	[[nodiscard]] bool Capturing() const
+	{
+		return framesLeft > 0;
+	}
+
+private:
+	struct Event
+	{
+		int thread;
+		ProfileEvent event;
+	};
+
+	// Passes the frame's events to the writer; holds the lock for a vector swap
+	void Hand()
+	{
+		if (batch.empty())
+			return;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (pending.empty())
+				pending.swap(batch);
+			else
+				pending.insert(pending.end(), batch.begin(), batch.end());
+		}
+		batch.clear();
+		wake.notify_one();
+	}
+
+	void Run()
+	{
+		std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", file);
+		std::vector<Event> writing;
+		bool done = false;
+		while (!done)
+		{
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				wake.wait(lock, [&] { return !pending.empty() || finishing; });
+				writing.swap(pending);
+				done = finishing && writing.empty();
+			}
+			for (const Event& e : writing)
+			{
+				std::fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+					events++ == 0 ? "" : ",\n", e.event.name, e.thread, (double)e.event.startNs / 1e3,
+					(double)(e.event.endNs - e.event.startNs) / 1e3);
+			}
+			writing.clear();
+		}
+
+		// Thread names as metadata events, known by now for every thread that recorded
+		for (int thread = 0; thread < Profiler::MAX_THREADS; thread++)
+		{
+			const char* name = Profiler::Get().ThreadName(thread);
+			if (name != nullptr)
+				std::fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+					events++ == 0 ? "" : ",\n", thread, name);
+		}
+		std::fputs("\n]}\n", file);
+		bool ok = std::fclose(file) == 0;
+		file = nullptr;
+		std::cout << (ok ? "Trace written to " : "Failed to write trace ") << path << std::endl;
+	}
+
+	std::string path;
+	FILE* file = nullptr;
+	int framesLeft = 0;                 // Main thread
+	bool profilerWasEnabled = false;
+	uint64_t enableCallsAtStart = 0;
+	std::vector<Event> batch;           // Main thread
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::vector<Event> pending;
+	bool finishing = false;
+	uint64_t events = 0;                // Writer thread
+	std::thread writer;
+};
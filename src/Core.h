@@ -0,0 +1,255 @@
+#pragma once
+#include <cmath>
+#include <iostream>
+
+// **********************************************************************************************
+//	Core Types shared by the game, the simulation and the tools
+// **********************************************************************************************
+
+enum eDirection {STOP = 0, LEFT, RIGHT, UP, DOWN};
+enum eDifficulty {EASY = 0, MEDIUM, HARD [[maybe_unused]]
+};
+
+struct Vector
+{
+    Vector() 
+	{
+		x = 0.0f;
+		y = 0.0f;
+	}
+    
+	Vector(float _x, float _y) 
+	{
+		x = _x;
+		y = _y;
+	}
+    
+	Vector(const Vector& v) = default;
+	Vector& operator=(const Vector& v) = default;
+	~Vector() = default;
+
+	static float Distance(const Vector& _this, const Vector& other)
+	{
+		float x = (other.x - _this.x);
+		float y = (other.y - _this.y);
+		float d = std::sqrt((x*x) + (y*y));
+		return d;
+	} 
+
+    Vector operator+(const Vector& other) const 
+	{
+        return {x + other.x, y + other.y};
+    }
+
+    Vector operator-(const Vector& other) const 
+	{
+        return {x - other.x, y - other.y};
+    }
+
+    Vector operator*(float s) const 
+	{
+        return {x * s, y * s};
+    }
+
+    Vector operator/(float s) const 
+	{
+        if (s != 0) {
+            return {x / s, y / s};
+        } else {
+            return *this;
+        }
+    }
+    
+	Vector& operator+=(const Vector& other) 
+	{
+        x += other.x;
+        y += other.y;
+        return *this;
+    }
+
+    Vector& operator-=(const Vector& other) 
+	{
+        x -= other.x;
+        y -= other.y;
+        return *this;
+    }
+
+    Vector& operator*=(float s) 
+	{
+        x *= s;
+        y *= s;
+        return *this;
+    }
+
+    Vector& operator/=(float s) 
+	{
+        if (s != 0) {
+            x /= s;
+            y /= s;
+        }
+        return *this;
+    }
+
+    float x, y;
+};
+
+inline Vector operator*(float s, const Vector& v) 
+{
+    return {v.x * s, v.y * s};
+}
+
+// Position a follower so it sits spacing units behind its leader, on the line joining them
+inline Vector FollowLeader(const Vector& leader, const Vector& follower, float spacing)
+{
+	Vector direction = leader - follower;
+	direction = direction / Vector::Distance(leader, follower);
+	return leader - direction * spacing;
+}
+
+struct Transform
+{
+	Transform()
+	{
+		position = Vector();
+	}
+	
+	explicit Transform(const Vector& _position) : position (_position){}
+	Vector position;
+
+	// Writes the 8 floats of a triangle strip quad around position
+	void GenQuadVertices(float rad, float* verts) const
+	{
+		verts[0] = position.x - rad; verts[1] = position.y + rad;
+		verts[2] = position.x + rad; verts[3] = position.y + rad;
+		verts[4] = position.x - rad; verts[5] = position.y - rad;
+		verts[6] = position.x + rad; verts[7] = position.y - rad;
+	}
+
+	void Translate(float* verts, float dX, float dY)
+	{
+		position.x += dX;
+		position.y += dY;
+		for (int i=0; i < 8; i++){
+			if(i%2 == 0)
+				verts[i] += dX;
+			else
+				verts[i] += dY;
+		}
+	}
+
+	static void Rotate(float* verts, float angle)
+	{
+		float arr[8] = {
+			verts[0] * std::cos(angle) + verts[1] * -1 * std::sin(angle),
+			verts[0] * std::sin(angle) + verts[1] * std::cos(angle),
+			verts[2] * std::cos(angle) + verts[3] * -1 * std::sin(angle),
+			verts[2] * std::sin(angle) + verts[3] * std::cos(angle),
+			verts[4] * std::cos(angle) + verts[5] * -1 * std::sin(angle),
+			verts[4] * std::sin(angle) + verts[5] * std::cos(angle),
+			verts[6] * std::cos(angle) + verts[7] * -1 * std::sin(angle),
+			verts[6] * std::sin(angle) + verts[7] * std::cos(angle)
+		};
+		verts[0] = arr[0];
+		verts[1] = arr[1];
+		verts[2] = arr[2];
+		verts[3] = arr[3];
+		verts[4] = arr[4];
+		verts[5] = arr[5];
+		verts[6] = arr[6];
+		verts[7] = arr[7];
+	}
+
+	static void Scale(float* verts, float sX, float sY)
+	{
+		for (int i=0; i < 8; i++){
+			if(i%2 == 0)
+				verts[i] *= sX;
+			else
+				verts[i] *= sY;
+		}
+	}
+};
+
+struct Entity
+{
+    Entity() 
+	{
+		transform = Transform();
+		setVertices();
+	}
+
+    explicit Entity(const Vector& _position, float scaleF = 0.025f)
+	{
+		transform = Transform(_position);
+        scaleFactor = scaleF;
+		setVertices(scaleFactor);
+	}
+    
+	Entity(const Entity& e, float scaleF = 0.025f)
+	{
+		transform = e.transform;
+        scaleFactor = e.scaleFactor;
+		setVertices(scaleFactor);
+	}
+	
+	Entity& operator=(const Entity& other) 
+	{
+        if (this == &other) {
+            return *this; // Self-assignment, no need to do anything
+        }
+
+        transform = other.transform;
+        scaleFactor = other.scaleFactor;
+        setVertices(scaleFactor);
+        return *this;
+    }
+
+    ~Entity()= default;
+    Transform transform;
+	float vertices[8]{};
+	Vector oldPosition;
+	float scaleFactor;
+
+	void setVertices(float scaleF = 0.025f)
+	{
+		transform.GenQuadVertices(scaleF, vertices);
+        scaleFactor = scaleF;
+	}
+
+	void printEntity() const
+	{
+		std::cout << transform.position.x << ", " << transform.position.y << std::endl;
+		for (int i=0; i < 8;){
+			std::cout << vertices[i++] << ", "<< vertices[i++] << std::endl;
+		}
+		std::cout << "\n";
+	}
+
+	void SetPosition(float x, float y, float scale = 0.25f)
+	{
+		oldPosition = transform.position;
+		transform.position.x = x;
+		transform.position.y = y;
+		setVertices(scale);
+	}
+
+	void SetPosition(const Vector& v, float scaleF = 0.25f)
+	{
+		oldPosition = transform.position;
+		transform.position = v;
+		setVertices(scaleF);
+	}
+	
+	void SetOldPosition(const Vector& pos)
+	{
+		oldPosition = pos;
+	}
+};
+
+inline bool HasCollided(const Entity& _this, const Entity& other)
+{
+	float distance = Vector::Distance(_this.transform.position, other.transform.position);
+	if (distance < other.scaleFactor * 2)
+		return true;
+	return false; 
+}
@@ -0,0 +1,308 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <vector>
+#include "Core.h"
+
+// **********************************************************************************************
+//	Simulation State
+// **********************************************************************************************
+//	GameState is a fixed-layout, trivially copyable copy of everything UpdateGame reads and
+//	writes. The live game keeps using Entities for rendering; SnapshotGame/RestoreGame in
+//	main.cpp move state between the two. StepGame advances a GameState with the same rules as
+//	UpdateGame, so search and rollback can run without touching the globals.
+
+const int MAX_TAIL_SEGMENTS = 1024;
+
+const float SNAKE_SCALE = 0.035f, TAIL_SCALE = 0.030f, FRUIT_SCALE = 0.025f;
+const float TAIL_SPACING = 0.070f;
+
+// Events raised by StepGame so the caller can play sounds
+enum eGameEvent {EVENT_NONE = 0, EVENT_ATE_FRUIT = 1, EVENT_NEW_LEVEL = 2, EVENT_GAME_OVER = 4};
+
+// xorshift64* - small, seedable and copyable with the state, unlike a time-seeded mt19937
+struct SimRandom
+{
+	uint64_t state;
+
+	void Seed(uint64_t seed)
+	{
+		state = seed ? seed : 0x9E3779B97F4A7C15ull;
+	}
+
+	uint32_t Next()
+	{
+		state ^= state >> 12;
+		state ^= state << 25;
+		state ^= state >> 27;
+		return (uint32_t)((state * 0x2545F4914F6CDD1Dull) >> 32);
+	}
+
+	float Range(float lo, float hi)
+	{
+		return lo + (hi - lo) * ((float)(Next() >> 8) * (1.0f / 16777216.0f));
+	}
+};
+
+inline Vector GenerateRandomPoint(SimRandom& rng)
+{
+	float x = rng.Range(-0.975f, 0.976f);
+	float y = rng.Range(-0.975f, 0.976f);
+	return {x, y};
+}
+
+struct Segment
+{
+	Vector position;
+	Vector oldPosition;
+};
+
+struct GameState
+{
+	Vector head, headOld;
+	Vector fruit;
+	Vector tailOffset;
+	float dX, dY, step;
+	eDirection dir;
+	eDifficulty difficulty;
+	uint32_t score, highScore, level, maxLevelScore;
+	uint32_t currentTime, fruitSpawnTime, fruitLifeSpan;
+	uint32_t tailCount;
+	bool gameOver, gameIsPaused;
+	SimRandom rng;
+	// Keep last: CopyGameState only copies the live prefix of this array
+	Segment tails[MAX_TAIL_SEGMENTS];
+};
+
+static_assert(std::is_trivially_copyable<GameState>::value, "GameState must stay memcpy-able");
+static_assert(std::is_standard_layout<GameState>::value, "GameState must keep a fixed layout");
+
+// Copies the header and the tailCount live segments; the rest of the array is left untouched
+inline void CopyGameState(GameState& dst, const GameState& src)
+{
+	std::memcpy((void*)&dst, (const void*)&src, offsetof(GameState, tails) + src.tailCount * sizeof(Segment));
+}
+
+inline void SetGameDifficulty(GameState& s, eDifficulty d)
+{
+	s.difficulty = d;
+	if (d == eDifficulty::EASY)
+	{
+		s.step = 0.25f;
+		s.fruitLifeSpan = 15000;
+	}
+	else if (d == eDifficulty::MEDIUM)
+	{
+		s.step = 0.45f;
+		s.fruitLifeSpan = 10000;
+	}
+	else
+	{
+		s.step = 0.65f;
+		s.fruitLifeSpan = 5000;
+	}
+}
+
+// Sound effects speed up with the difficulty, matching the faster snake
+inline float EffectPitch(eDifficulty d)
+{
+	return 1.0f + 0.125f * (float)d;
+}
+
+// A fresh round as started by the RETURN key: snake at the origin heading up
+inline void InitGameState(GameState& s, uint64_t seed, eDifficulty d = eDifficulty::EASY)
+{
+	std::memset((void*)&s, 0, offsetof(GameState, tails));
+	s.rng.Seed(seed);
+	SetGameDifficulty(s, d);
+	s.level = 1;
+	s.maxLevelScore = 5;
+	s.fruit = GenerateRandomPoint(s.rng);
+	s.dX = 0.0f; s.dY = s.step;
+	s.tailOffset = Vector(0.0f, -0.07f);
+	s.dir = eDirection::UP;
+}
+
+// Same rules as the arrow keys in HandleInput: no reversing onto the tail
+inline void SteerGame(GameState& s, eDirection d)
+{
+	if (d == eDirection::STOP)
+		return;
+	s.gameIsPaused = false;
+	if (d == eDirection::LEFT && s.dir != eDirection::RIGHT)
+	{
+		s.dX = -s.step; s.dY = 0.0f;
+		s.tailOffset = Vector(0.07f, 0.0f);
+		s.dir = d;
+	}
+	else if (d == eDirection::RIGHT && s.dir != eDirection::LEFT)
+	{
+		s.dX = s.step; s.dY = 0.0f;
+		s.tailOffset = Vector(-0.07f, 0.0f);
+		s.dir = d;
+	}
+	else if (d == eDirection::UP && s.dir != eDirection::DOWN)
+	{
+		s.dX = 0.0f; s.dY = s.step;
+		s.tailOffset = Vector(0.0f, -0.07f);
+		s.dir = d;
+	}
+	else if (d == eDirection::DOWN && s.dir != eDirection::UP)
+	{
+		s.dX = 0.0f; s.dY = -s.step;
+		s.tailOffset = Vector(0.0f, 0.07f);
+		s.dir = d;
+	}
+}
+
+inline void EndGameState(GameState& s)
+{
+	s.dir = eDirection::STOP;
+	s.gameOver = true;
+	if (s.score > s.highScore)
+		s.highScore = s.score;
+	s.level = 1;
+	s.maxLevelScore = 5;
+}
+
+// RETURN after a game over (RestartGame): a new round that keeps the clock, fruit and random stream
+inline void RestartGameState(GameState& s)
+{
+	s.head = Vector();
+	s.headOld = Vector();
+	s.tailCount = 0;
+	s.score = 0;
+	s.gameOver = false;
+	s.gameIsPaused = false;
+	s.fruitSpawnTime = s.currentTime;
+	s.dX = 0.0f; s.dY = s.step;
+	s.tailOffset = Vector(0.0f, -0.07f);
+	s.dir = eDirection::UP;
+}
+
+// Advances the state by deltaMs milliseconds; mirrors UpdateGame. Returns eGameEvent flags.
+inline int StepGame(GameState& s, uint32_t deltaMs)
+{
+	int events = EVENT_NONE;
+	s.currentTime += deltaMs;
+	if (s.gameOver || s.gameIsPaused)
+		return events;
+
+	float deltaTime = (float)deltaMs / 1000.0f;
+
+	if (s.currentTime - s.fruitSpawnTime > s.fruitLifeSpan)
+	{
+		s.fruit = GenerateRandomPoint(s.rng);
+		s.fruitSpawnTime = s.currentTime;
+	}
+
+	s.headOld = s.head;
+	s.head.x += s.dX * deltaTime;
+	s.head.y += s.dY * deltaTime;
+
+	for (int i = (int)s.tailCount - 1; i >= 0; i--)
+	{
+		const Vector& leader = (i == 0) ? s.head : s.tails[i - 1].position;
+		Segment& segment = s.tails[i];
+		segment.oldPosition = segment.position;
+		segment.position = FollowLeader(leader, segment.position, TAIL_SPACING);
+
+		if (i > 0 && Vector::Distance(s.head, segment.position) < TAIL_SCALE * 2)
+		{
+			EndGameState(s);
+			events |= EVENT_GAME_OVER;
+			break;
+		}
+	}
+
+	if (Vector::Distance(s.head, s.fruit) < FRUIT_SCALE * 2)
+	{
+		s.fruit = GenerateRandomPoint(s.rng);
+		if (s.tailCount < (uint32_t)MAX_TAIL_SEGMENTS)
+		{
+			Vector anchor = s.tailCount == 0 ? s.headOld : s.tails[s.tailCount - 1].oldPosition;
+			s.tails[s.tailCount].position = anchor + s.tailOffset;
+			s.tails[s.tailCount].oldPosition = Vector();
+			s.tailCount++;
+		}
+		s.score++;
+		s.fruitSpawnTime = s.currentTime;
+		events |= EVENT_ATE_FRUIT;
+
+		if (s.score == s.maxLevelScore)
+		{
+			s.level++;
+			s.tailCount = 0;
+			s.headOld = s.head;
+			s.head = Vector();
+			s.dir = eDirection::STOP;
+			s.maxLevelScore += (s.level * 5);
+			events |= EVENT_NEW_LEVEL;
+		}
+	}
+	else if (s.head.x < -0.999f || s.head.x > 0.999f || s.head.y < -0.999f || s.head.y > 0.999f)
+	{
+		EndGameState(s);
+		events |= EVENT_GAME_OVER;
+	}
+	return events;
+}
+
+// **********************************************************************************************
+//	Snapshot Pool
+// **********************************************************************************************
+//	Preallocated GameState slots with a free list so search and rollback can fork states
+//	without touching the heap. Not thread-safe: give each worker its own pool.
+
+class SnapshotPool
+{
+public:
+	explicit SnapshotPool(size_t capacity) : slots(new GameState[capacity]), capacity(capacity)
+	{
+		freeList.reserve(capacity);
+		for (size_t i = capacity; i > 0; i--)
+			freeList.push_back((uint32_t)(i - 1));
+	}
+
+	// Returns nullptr when the pool is exhausted
+	GameState* Fork(const GameState& source)
+	{
+		if (freeList.empty())
+			return nullptr;
+		GameState* state = &slots[freeList.back()];
+		freeList.pop_back();
+		CopyGameState(*state, source);
+		return state;
+	}
+
+	void Release(GameState* state)
+	{
+		freeList.push_back((uint32_t)(state - slots.get()));
+	}
+
+	// Returns every slot to the pool at once
+	void Reset()
+	{
+		freeList.clear();
+		for (size_t i = capacity; i > 0; i--)
+			freeList.push_back((uint32_t)(i - 1));
+	}
+
+	[[nodiscard]] size_t Available() const
+	{
+		return freeList.size();
+	}
+
+	[[nodiscard]] size_t Capacity() const
+	{
+		return capacity;
+	}
+
+private:
+	std::unique_ptr<GameState[]> slots;
+	size_t capacity;
+	std::vector<uint32_t> freeList;
+};
@@ -0,0 +1,89 @@
+#pragma once
+#include "GLEW/glew.h"
+#include "Profiler.h"
+
+// **********************************************************************************************
+//	GPU Timer Pool
+// **********************************************************************************************
+//	Measures GPU time of parts of a frame with GL_TIME_ELAPSED queries. Queries live in a ring of
+//	FRAMES_IN_FLIGHT sets; a set is read back only when its frame comes round again, by which time
+//	the GPU has long finished it, so reading never stalls the pipeline. Results reach the profiler
+//	FRAMES_IN_FLIGHT - 1 frames after they were measured.
+//
+//	Timer queries cannot nest: End one scope before the next Begin.
+
+class GpuTimerPool
+{
+public:
+	static const int FRAMES_IN_FLIGHT = 4;
+	static const int MAX_QUERIES = 8;
+
+	// Needs a current GL context
+	void Create()
+	{
+		glGenQueries(FRAMES_IN_FLIGHT * MAX_QUERIES, &queries[0][0]);
+		created = true;
+	}
+
+	void Destroy()
+	{
+		if (created)
+			glDeleteQueries(FRAMES_IN_FLIGHT * MAX_QUERIES, &queries[0][0]);
+		created = false;
+	}
+
+	void Begin(const char* name)
+	{
+		if (!created || !Profiler::Get().Enabled() || used[current] == MAX_QUERIES)
+			return;
+		int index = used[current]++;
+		names[current][index] = name;
+		glBeginQuery(GL_TIME_ELAPSED, queries[current][index]);
+		active = true;
+	}
+
+	void End()
+	{
+		if (!active)
+			return;
+		glEndQuery(GL_TIME_ELAPSED);
+		active = false;
+	}
+
+	// Call once per frame after the last End: reads back the oldest set and reuses it
+	void EndFrame()
+	{
+		if (!created)
+			return;
+		current = (current + 1) % FRAMES_IN_FLIGHT;
+		for (int i = 0; i < used[current]; i++)
+		{
+			GLint available = 0;
+			glGetQueryObjectiv(queries[current][i], GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available)
+			{
+				late++;
+				continue;
+			}
+			GLuint64 ns = 0;
+			glGetQueryObjectui64v(queries[current][i], GL_QUERY_RESULT, &ns);
+			Profiler::Get().RecordGpu(names[current][i], (double)ns / 1e6);
+		}
+		used[current] = 0;
+	}
+
+	// Results that were still pending a full ring later and were skipped
+	[[nodiscard]] uint64_t LateResults() const
+	{
+		return late;
+	}
+
+private:
+	GLuint queries[FRAMES_IN_FLIGHT][MAX_QUERIES] = {};
+	const char* names[FRAMES_IN_FLIGHT][MAX_QUERIES] = {};
+	int used[FRAMES_IN_FLIGHT] = {};
+	int current = 0;
+	bool created = false;
+	bool active = false;
+	uint64_t late = 0;
+};
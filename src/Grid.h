@@ -0,0 +1,119 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "Core.h"
+
+// **********************************************************************************************
+//	Board Grid
+// **********************************************************************************************
+//	Discrete view of the [-1, 1] board for the grid-based autopilots. The default cell is one
+//	tail spacing wide, so consecutive tail segments land in neighbouring cells. Neighbours are
+//	precomputed per cell in eDirection order (LEFT, RIGHT, UP, DOWN) with -1 off the board.
+
+const int DIRECTION_COUNT = 4;
+const eDirection GRID_DIRECTIONS[DIRECTION_COUNT] = {eDirection::LEFT, eDirection::RIGHT, eDirection::UP, eDirection::DOWN};
+
+struct BoardGrid
+{
+	explicit BoardGrid(int width = 28, int height = 28) : width(width), height(height)
+	{
+		cellWidth = 2.0f / (float)width;
+		cellHeight = 2.0f / (float)height;
+		neighbors.resize((size_t)width * height * DIRECTION_COUNT);
+		for (int y = 0; y < height; y++)
+		{
+			for (int x = 0; x < width; x++)
+			{
+				int* n = &neighbors[(size_t)(y * width + x) * DIRECTION_COUNT];
+				n[0] = x > 0 ? Cell(x - 1, y) : -1;
+				n[1] = x < width - 1 ? Cell(x + 1, y) : -1;
+				n[2] = y < height - 1 ? Cell(x, y + 1) : -1;
+				n[3] = y > 0 ? Cell(x, y - 1) : -1;
+			}
+		}
+	}
+
+	[[nodiscard]] int Cells() const
+	{
+		return width * height;
+	}
+
+	[[nodiscard]] int Cell(int x, int y) const
+	{
+		return y * width + x;
+	}
+
+	[[nodiscard]] int CellOf(const Vector& p) const
+	{
+		int x = std::clamp((int)((p.x + 1.0f) / cellWidth), 0, width - 1);
+		int y = std::clamp((int)((p.y + 1.0f) / cellHeight), 0, height - 1);
+		return Cell(x, y);
+	}
+
+	[[nodiscard]] Vector CellCenter(int cell) const
+	{
+		return {-1.0f + ((float)(cell % width) + 0.5f) * cellWidth, -1.0f + ((float)(cell / width) + 0.5f) * cellHeight};
+	}
+
+	// True once a head travelling in dir has reached the middle of its cell
+	[[nodiscard]] bool PastCellCenter(int cell, const Vector& head, eDirection dir) const
+	{
+		Vector center = CellCenter(cell);
+		switch (dir)
+		{
+			case eDirection::LEFT: return head.x <= center.x;
+			case eDirection::RIGHT: return head.x >= center.x;
+			case eDirection::UP: return head.y >= center.y;
+			case eDirection::DOWN: return head.y <= center.y;
+			default: return true;
+		}
+	}
+
+	// Neighbour of cell in GRID_DIRECTIONS[d], or -1
+	[[nodiscard]] int Neighbor(int cell, int d) const
+	{
+		return neighbors[(size_t)cell * DIRECTION_COUNT + d];
+	}
+
+	// Direction that moves from one cell to an adjacent one
+	[[nodiscard]] eDirection DirectionTo(int from, int to) const
+	{
+		for (int d = 0; d < DIRECTION_COUNT; d++)
+			if (Neighbor(from, d) == to)
+				return GRID_DIRECTIONS[d];
+		return eDirection::STOP;
+	}
+
+	int width, height;
+	float cellWidth, cellHeight;
+	std::vector<int> neighbors;
+};
+
+// One bit per cell
+struct CellBitset
+{
+	explicit CellBitset(int cells = 0) : words(((size_t)cells + 63) / 64, 0) {}
+
+	void Clear()
+	{
+		std::fill(words.begin(), words.end(), 0ull);
+	}
+
+	void Set(int cell)
+	{
+		words[(size_t)cell >> 6] |= 1ull << (cell & 63);
+	}
+
+	void Reset(int cell)
+	{
+		words[(size_t)cell >> 6] &= ~(1ull << (cell & 63));
+	}
+
+	[[nodiscard]] bool Test(int cell) const
+	{
+		return (words[(size_t)cell >> 6] >> (cell & 63)) & 1ull;
+	}
+
+	std::vector<uint64_t> words;
+};
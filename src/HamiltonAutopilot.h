@@ -0,0 +1,295 @@
+#pragma once
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "Autopilot.h"
+#include "Grid.h"
+
+// **********************************************************************************************
+//	Hamiltonian Cycle Autopilot
+// **********************************************************************************************
+//	Follows a cycle that visits every cell of the BoardGrid once, so the snake can grow until
+//	it fills the board. While the snake is short it may leave the cycle for a neighbour that is
+//	further along it, as long as the jump does not pass the fruit and leaves the whole body
+//	behind the head in cycle order.
+//
+//	The cycle is a serpentine over every column but the first, closed by running back down the
+//	first column. It needs an even number of rows, so a board with an odd height runs it over
+//	the columns instead, and an odd-by-odd board drops its last column. Both sides are at least 2.
+//	Cycles are cached on disk as <cacheDirectory>hamilton_<W>x<H>.bin.
+//
+//	The default cell is wider than the path autopilot's: the tail is dragged like a rope and
+//	cuts inside corners, and the hairpins of a finer cycle bring the head within collision
+//	distance of it.
+
+class HamiltonAutopilot : public Autopilot
+{
+public:
+	explicit HamiltonAutopilot(int width = 16, int height = 16, const std::string& cacheDirectory = "../cache/")
+		: grid(std::max(2, width), std::max(2, height)), order(grid.Cells(), -1), cycle()
+	{
+		cachePath = cacheDirectory + "hamilton_" + std::to_string(grid.width) + "x" + std::to_string(grid.height) + ".bin";
+		Clock::time_point start = Clock::now();
+		loadedFromCache = LoadCycle();
+		if (!loadedFromCache)
+		{
+			BuildCycle();
+			SaveCycle();
+		}
+		setupMs = MillisecondsSince(start);
+	}
+
+	eDirection Decide(const GameState& state) override
+	{
+		Clock::time_point start = Clock::now();
+		int headCell = grid.CellOf(state.head);
+		eDirection d = state.dir;
+		if (state.dir == eDirection::STOP || (headCell != plannedCell && grid.PastCellCenter(headCell, state.head, state.dir)))
+		{
+			d = Plan(state, headCell);
+			plannedCell = headCell;
+		}
+		stats.Record(MillisecondsSince(start));
+		return d;
+	}
+
+	void Report(std::ostream& out) const override
+	{
+		out << "[Hamilton] grid " << grid.width << "x" << grid.height << "  cycle length " << cycle.size()
+			<< "  setup ms " << setupMs << (loadedFromCache ? " (cache)" : " (built)")
+			<< "  shortcuts " << shortcuts << " cycle moves " << cycleMoves << "\n";
+		out << "[Hamilton] ";
+		stats.Report(out, "decisions");
+	}
+
+private:
+	static const uint32_t CACHE_MAGIC = 0x43594348; // "HCYC"
+	static const uint32_t CACHE_VERSION = 1;
+	// Cycle moves between two shortcuts; back-to-back jumps fold the tail into the head
+	static const int SHORTCUT_COOLDOWN = 3;
+
+	// Cells ahead of from when walking the cycle to to
+	[[nodiscard]] int CycleDistance(int from, int to) const
+	{
+		int n = (int)cycle.size();
+		return (order[to] - order[from] + n) % n;
+	}
+
+	[[nodiscard]] bool OnCycle(int cell) const
+	{
+		return cell >= 0 && order[cell] >= 0;
+	}
+
+	// The serpentine runs along rows of cols cells; transposed, its rows are the board's columns.
+	// rows is made even, dropping the last board column when both sides are odd and no
+	// Hamiltonian cycle exists.
+	void CycleShape(bool& transposed, int& rows, int& cols) const
+	{
+		transposed = grid.height % 2 != 0;
+		rows = transposed ? grid.width : grid.height;
+		cols = transposed ? grid.height : grid.width;
+		if (rows % 2 != 0)
+			rows--;
+	}
+
+	// Cells on the cycle BuildCycle makes
+	[[nodiscard]] int CycleLength() const
+	{
+		bool transposed;
+		int rows, cols;
+		CycleShape(transposed, rows, cols);
+		return rows * cols;
+	}
+
+	void BuildCycle()
+	{
+		bool transposed;
+		int rows, cols;
+		CycleShape(transposed, rows, cols);
+
+		auto cell = [&](int c, int r) { return transposed ? grid.Cell(r, c) : grid.Cell(c, r); };
+
+		cycle.clear();
+		for (int r = 0; r < rows; r++)
+		{
+			if (r % 2 == 0)
+				for (int c = 1; c < cols; c++)
+					cycle.push_back(cell(c, r));
+			else
+				for (int c = cols - 1; c >= 1; c--)
+					cycle.push_back(cell(c, r));
+		}
+		for (int r = rows - 1; r >= 0; r--)
+			cycle.push_back(cell(0, r));
+
+		std::fill(order.begin(), order.end(), -1);
+		for (size_t i = 0; i < cycle.size(); i++)
+			order[cycle[i]] = (int)i;
+	}
+
+	bool LoadCycle()
+	{
+		FILE* file = std::fopen(cachePath.c_str(), "rb");
+		if (!file)
+			return false;
+
+		uint32_t header[4] = {};
+		bool ok = std::fread(header, sizeof(header), 1, file) == 1
+			&& header[0] == CACHE_MAGIC && header[1] == CACHE_VERSION
+			&& (int)header[2] == grid.width && (int)header[3] == grid.height;
+
+		uint32_t length = 0;
+		ok = ok && std::fread(&length, sizeof(length), 1, file) == 1 && length == (uint32_t)CycleLength();
+		if (ok)
+		{
+			cycle.resize(length);
+			ok = std::fread(cycle.data(), sizeof(int), length, file) == length;
+		}
+		uint32_t checksum = 0, stored = 0;
+		ok = ok && std::fread(&stored, sizeof(stored), 1, file) == 1;
+		std::fclose(file);
+		if (!ok)
+			return false;
+
+		// Reject anything that is not a closed cycle of adjacent, distinct cells; with the length
+		// check above it covers the board, so following it never runs into the tail
+		std::fill(order.begin(), order.end(), -1);
+		for (uint32_t i = 0; i < length; i++)
+		{
+			int c = cycle[i];
+			checksum = checksum * 31u + (uint32_t)c;
+			if (c < 0 || c >= grid.Cells() || order[c] != -1
+				|| grid.DirectionTo(c, cycle[(i + 1) % length]) == eDirection::STOP)
+				return false;
+			order[c] = (int)i;
+		}
+		return checksum == stored;
+	}
+
+	void SaveCycle() const
+	{
+		// Write to a temporary file first so a crash never leaves a torn cache behind
+		std::string temporary = cachePath + ".tmp";
+		FILE* file = std::fopen(temporary.c_str(), "wb");
+		if (!file)
+			return;
+
+		uint32_t header[4] = {CACHE_MAGIC, CACHE_VERSION, (uint32_t)grid.width, (uint32_t)grid.height};
+		uint32_t length = (uint32_t)cycle.size(), checksum = 0;
+		for (int c : cycle)
+			checksum = checksum * 31u + (uint32_t)c;
+
+		bool ok = std::fwrite(header, sizeof(header), 1, file) == 1
+			&& std::fwrite(&length, sizeof(length), 1, file) == 1
+			&& std::fwrite(cycle.data(), sizeof(int), length, file) == length
+			&& std::fwrite(&checksum, sizeof(checksum), 1, file) == 1;
+		ok = (std::fclose(file) == 0) && ok;
+
+		std::remove(cachePath.c_str());
+		if (!ok || std::rename(temporary.c_str(), cachePath.c_str()) != 0)
+			std::remove(temporary.c_str());
+	}
+
+	// Is a tail segment that the head can collide with in this cell?
+	[[nodiscard]] bool Occupied(const GameState& state, int cell) const
+	{
+		for (uint32_t i = 1; i < state.tailCount; i++)
+			if (grid.CellOf(state.tails[i].position) == cell)
+				return true;
+		return false;
+	}
+
+	eDirection Plan(const GameState& state, int headCell)
+	{
+		if (!OnCycle(headCell))
+		{
+			// Off the cycle (odd board edge): step back onto it
+			for (int d = 0; d < DIRECTION_COUNT; d++)
+				if (OnCycle(grid.Neighbor(headCell, d)) && GRID_DIRECTIONS[d] != OppositeDirection(state.dir))
+					return GRID_DIRECTIONS[d];
+			return state.dir;
+		}
+
+		int n = (int)cycle.size();
+		int next = cycle[(order[headCell] + 1) % n];
+		int fruitCell = grid.CellOf(state.fruit);
+
+		// Cycle distance to the nearest body cell ahead of the head. The tail follows the head's
+		// path rather than the cycle, so after a jump some of it may sit ahead of the head until
+		// the whole body (length cells) has moved on
+		int room = n;
+		for (uint32_t i = 0; i < state.tailCount; i++)
+		{
+			int cell = grid.CellOf(state.tails[i].position);
+			if (OnCycle(cell) && cell != headCell)
+				room = std::min(room, CycleDistance(headCell, cell));
+		}
+
+		// Only cut corners while the board is mostly empty, keep a margin for growth
+		int length = (int)state.tailCount + 1;
+		int best = next;
+		if (OnCycle(fruitCell) && length < n / 2 && cooldown == 0)
+		{
+			int fruitDistance = CycleDistance(headCell, fruitCell);
+			int bestDistance = 1;
+			for (int d = 0; d < DIRECTION_COUNT; d++)
+			{
+				int cell = grid.Neighbor(headCell, d);
+				if (!OnCycle(cell) || GRID_DIRECTIONS[d] == OppositeDirection(state.dir))
+					continue;
+				int distance = CycleDistance(headCell, cell);
+				if (distance > bestDistance && distance <= fruitDistance && distance < room - length - 2)
+				{
+					best = cell;
+					bestDistance = distance;
+				}
+			}
+		}
+
+		eDirection d = grid.DirectionTo(headCell, best);
+		if (d == OppositeDirection(state.dir) || Occupied(state, best))
+		{
+			best = next;
+			d = grid.DirectionTo(headCell, next);
+		}
+
+		// The tail is dragged like a rope and drifts inside corners, so it can end up on the
+		// cycle ahead of the head; sidestep it rather than run into it
+		if (Occupied(state, best))
+		{
+			for (int k = 0; k < DIRECTION_COUNT; k++)
+			{
+				int cell = grid.Neighbor(headCell, k);
+				if (OnCycle(cell) && GRID_DIRECTIONS[k] != OppositeDirection(state.dir) && !Occupied(state, cell))
+				{
+					best = cell;
+					d = GRID_DIRECTIONS[k];
+					break;
+				}
+			}
+		}
+
+		if (best == next)
+		{
+			cycleMoves++;
+			cooldown = cooldown > 0 ? cooldown - 1 : 0;
+		}
+		else
+		{
+			shortcuts++;
+			cooldown = SHORTCUT_COOLDOWN;
+		}
+		return d;
+	}
+
+	BoardGrid grid;
+	std::vector<int> order;
+	std::vector<int> cycle;
+	std::string cachePath;
+	bool loadedFromCache = false;
+	double setupMs = 0.0;
+	int plannedCell = -1;
+	int cooldown = 0;
+	uint64_t shortcuts = 0, cycleMoves = 0;
+};
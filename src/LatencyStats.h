@@ -0,0 +1,46 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <ostream>
+
+// **********************************************************************************************
+//	Latency Statistics
+// **********************************************************************************************
+//	Fixed-size window of the most recent samples plus running totals. Record never allocates,
+//	so it is safe on the audio thread; Percentile sorts a stack copy and is meant for reports.
+
+struct LatencyStats
+{
+	static const int WINDOW = 1024;
+
+	uint64_t count = 0;
+	double total = 0.0, max = 0.0;
+	float samples[WINDOW] = {};
+
+	void Record(double value)
+	{
+		samples[count % WINDOW] = (float)value;
+		count++;
+		total += value;
+		max = std::max(max, value);
+	}
+
+	[[nodiscard]] double Percentile(double p) const
+	{
+		int n = (int)std::min<uint64_t>(count, WINDOW);
+		if (n == 0)
+			return 0.0;
+		float sorted[WINDOW];
+		std::copy(samples, samples + n, sorted);
+		int k = std::min(n - 1, (int)(p * (n - 1) + 0.5));
+		std::nth_element(sorted, sorted + k, sorted + n);
+		return sorted[k];
+	}
+
+	void Report(std::ostream& out, const char* name, const char* unit = "ms") const
+	{
+		out << name << ": " << count << "  " << unit << " avg " << (count ? total / (double)count : 0.0)
+			<< " p50 " << Percentile(0.50) << " p95 " << Percentile(0.95) << " p99 " << Percentile(0.99)
+			<< " max " << max << "\n";
+	}
+};
@@ -0,0 +1,251 @@
+#pragma once
+#include <cmath>
+#include <memory>
+#include <vector>
+#include "Autopilot.h"
+#include "TaskRunner.h"
+
+// **********************************************************************************************
+//	Monte-Carlo Tree Search Autopilot
+// **********************************************************************************************
+//	Root parallelization: every tree searches independently from the same root snapshot on its
+//	own worker, then the visit counts of the root moves are summed and the most visited move
+//	wins. Nodes do not store states; each playout copies the root into a scratch GameState and
+//	replays the moves on the way down. An action is "steer, then run thinkTicks ticks".
+//
+//	With a playout budget the result only depends on the root state and the tree count, not
+//	on how many threads the runner has.
+
+struct MctsConfig
+{
+	unsigned int trees = 8;             // Independent root-parallel trees
+	unsigned int threads = 0;           // Worker threads (0 = one per core)
+	unsigned int playouts = 2000;       // Playout budget per decision when timeBudgetMs is 0
+	double timeBudgetMs = 0.0;          // Wall-clock budget per decision, overrides playouts
+	unsigned int thinkTicks = 8;        // Ticks simulated per action
+	unsigned int tickMs = 16;           // Simulation tick length
+	unsigned int rolloutDepth = 12;     // Random actions per rollout
+	float exploration = 1.41f;          // UCT exploration constant
+	unsigned int maxNodesPerTree = 1 << 15;
+};
+
+class MctsAutopilot : public Autopilot
+{
+public:
+	explicit MctsAutopilot(const MctsConfig& config = MctsConfig()) : config(config), runner(config.threads)
+	{
+		if (this->config.trees == 0)
+			this->config.trees = 1;
+		for (unsigned int i = 0; i < this->config.trees; i++)
+			trees.emplace_back(new Tree(this->config.maxNodesPerTree));
+	}
+
+	eDirection Decide(const GameState& state) override
+	{
+		Clock::time_point start = Clock::now();
+		Clock::time_point deadline = start + std::chrono::microseconds((int64_t)(config.timeBudgetMs * 1000.0));
+		uint64_t seed = state.rng.state + stats.count;
+
+		runner.ParallelFor(trees.size(), [&](size_t i) {
+			PROFILE_SCOPE("mcts search");
+			Search(*trees[i], state, TaskRunner::TaskSeed(seed, i), deadline);
+		});
+
+		// Merge root statistics across trees
+		uint64_t visits[5] = {};
+		for (auto& tree : trees)
+		{
+			const Node& root = tree->nodes[0];
+			for (uint32_t c = 0; c < root.childCount; c++)
+			{
+				const Node& child = tree->nodes[root.firstChild + c];
+				visits[child.action] += child.visits;
+			}
+			playouts += tree->playouts;
+		}
+
+		eDirection best = state.dir;
+		uint64_t bestVisits = 0;
+		for (int a = eDirection::LEFT; a <= eDirection::DOWN; a++)
+		{
+			if (visits[a] > bestVisits)
+			{
+				bestVisits = visits[a];
+				best = (eDirection)a;
+			}
+		}
+
+		double ms = MillisecondsSince(start);
+		searchMs += ms;
+		stats.Record(ms);
+		return best;
+	}
+
+	void Report(std::ostream& out) const override
+	{
+		out << "[MCTS] trees " << trees.size() << " threads " << runner.ThreadCount()
+			<< "  playouts " << playouts
+			<< "  playouts/s " << (searchMs > 0.0 ? (double)playouts * 1000.0 / searchMs : 0.0) << "\n";
+		out << "[MCTS] ";
+		stats.Report(out, "decisions");
+	}
+
+private:
+	struct Node
+	{
+		uint32_t parent;
+		uint32_t firstChild;
+		uint32_t visits;
+		float value;
+		uint8_t childCount;
+		uint8_t action;
+		bool terminal;
+	};
+
+	struct Tree
+	{
+		explicit Tree(unsigned int capacity) : scratch(new GameState())
+		{
+			nodes.reserve(capacity);
+		}
+
+		std::vector<Node> nodes;
+		std::unique_ptr<GameState> scratch;
+		SimRandom rng{};
+		uint64_t playouts = 0;
+	};
+
+	// Steers and runs one action; returns false if the snake died
+	bool Apply(GameState& s, eDirection action) const
+	{
+		SteerGame(s, action);
+		for (unsigned int t = 0; t < config.thinkTicks && !s.gameOver; t++)
+			StepGame(s, config.tickMs);
+		return !s.gameOver;
+	}
+
+	static int LegalActions(const GameState& s, uint8_t* out)
+	{
+		int n = 0;
+		eDirection reverse = OppositeDirection(s.dir);
+		for (int a = eDirection::LEFT; a <= eDirection::DOWN; a++)
+			if (a != reverse)
+				out[n++] = (uint8_t)a;
+		return n;
+	}
+
+	// Light random policy, scored on fruit eaten, survival and distance to the fruit
+	float Rollout(GameState& s, SimRandom& rng, uint32_t startScore) const
+	{
+		unsigned int depth = 0;
+		uint8_t actions[4];
+		for (; depth < config.rolloutDepth && !s.gameOver; depth++)
+		{
+			int n = LegalActions(s, actions);
+			// Keep going straight half of the time, snakes that wiggle die young
+			eDirection a = (rng.Next() & 1) && s.dir != eDirection::STOP ? s.dir : (eDirection)actions[rng.Next() % n];
+			if (!Apply(s, a))
+				break;
+		}
+
+		if (s.gameOver)
+			return 0.1f * (float)depth / (float)config.rolloutDepth;
+
+		float gained = std::min(1.0f, (float)(s.score - startScore));
+		float closeness = 1.0f - std::min(Vector::Distance(s.head, s.fruit), 2.83f) / 2.83f;
+		return 0.4f + 0.4f * gained + 0.2f * closeness;
+	}
+
+	uint32_t SelectChild(const Tree& tree, const Node& node) const
+	{
+		float logVisits = std::log((float)node.visits + 1.0f);
+		uint32_t best = node.firstChild;
+		float bestScore = -1.0f;
+		for (uint32_t c = 0; c < node.childCount; c++)
+		{
+			const Node& child = tree.nodes[node.firstChild + c];
+			if (child.visits == 0)
+				return node.firstChild + c;
+			float score = child.value / (float)child.visits + config.exploration * std::sqrt(logVisits / (float)child.visits);
+			if (score > bestScore)
+			{
+				bestScore = score;
+				best = node.firstChild + c;
+			}
+		}
+		return best;
+	}
+
+	void Expand(Tree& tree, uint32_t index, const GameState& s)
+	{
+		uint8_t actions[4];
+		int n = LegalActions(s, actions);
+		if (tree.nodes.size() + n > tree.nodes.capacity())
+			return;
+		uint32_t first = (uint32_t)tree.nodes.size();
+		for (int i = 0; i < n; i++)
+			tree.nodes.push_back(Node{index, 0, 0, 0.0f, 0, actions[i], false});
+		tree.nodes[index].firstChild = first;
+		tree.nodes[index].childCount = (uint8_t)n;
+	}
+
+	void Search(Tree& tree, const GameState& root, uint64_t seed, Clock::time_point deadline)
+	{
+		tree.nodes.clear();
+		tree.nodes.push_back(Node{0, 0, 0, 0.0f, 0, (uint8_t)root.dir, root.gameOver});
+		tree.rng.Seed(seed);
+		tree.playouts = 0;
+
+		unsigned int budget = (config.playouts + config.trees - 1) / config.trees;
+		bool timed = config.timeBudgetMs > 0.0;
+		GameState& s = *tree.scratch;
+
+		for (;;)
+		{
+			if (timed ? ((tree.playouts & 7) == 0 && Clock::now() >= deadline) : tree.playouts >= budget)
+				break;
+
+			CopyGameState(s, root);
+			uint32_t index = 0;
+
+			// Selection
+			while (tree.nodes[index].childCount > 0 && !tree.nodes[index].terminal)
+			{
+				index = SelectChild(tree, tree.nodes[index]);
+				if (!Apply(s, (eDirection)tree.nodes[index].action))
+					tree.nodes[index].terminal = true;
+			}
+
+			// Expansion
+			if (!tree.nodes[index].terminal && tree.nodes[index].visits > 0)
+			{
+				Expand(tree, index, s);
+				if (tree.nodes[index].childCount > 0)
+				{
+					index = tree.nodes[index].firstChild;
+					if (!Apply(s, (eDirection)tree.nodes[index].action))
+						tree.nodes[index].terminal = true;
+				}
+			}
+
+			// Simulation and backpropagation
+			float reward = Rollout(s, tree.rng, root.score);
+			for (;;)
+			{
+				Node& node = tree.nodes[index];
+				node.visits++;
+				node.value += reward;
+				if (index == 0)
+					break;
+				index = node.parent;
+			}
+			tree.playouts++;
+		}
+	}
+
+	MctsConfig config;
+	TaskRunner runner;
+	std::vector<std::unique_ptr<Tree>> trees;
+	uint64_t playouts = 0;
+	double searchMs = 0.0;
+};
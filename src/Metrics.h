@@ -0,0 +1,282 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#if !defined(_WIN32)
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+// **********************************************************************************************
+//	Live Metrics
+// **********************************************************************************************
+//	Counters, gauges and a frame-time histogram that can be read from outside the process. Start
+//	listens on a Unix domain socket; every connection gets one snapshot in the Prometheus text
+//	format and is closed, e.g.
+//		socat - UNIX-CONNECT:/tmp/snake.sock
+//
+//	Each thread writes counters in its own cache-line aligned slot. A slot has a single writer,
+//	so an increment is a relaxed load and store with no lock prefix and no shared cache line.
+//	The server thread adds the slots up when a client connects. Gauges are a relaxed store.
+//	Samplers are functions the server calls at snapshot time for values other modules already
+//	keep in atomics, such as audio underruns; they must be safe to call from any thread.
+//
+//	POSIX only; Start fails on Windows.
+
+enum eMetricCounter {METRIC_FRAMES = 0, METRIC_TICKS, METRIC_DRAW_CALLS, METRIC_COUNTERS};
+enum eMetricGauge {GAUGE_SNAKE_LENGTH = 0, GAUGE_SCORE, METRIC_GAUGES};
+
+class Metrics
+{
+public:
+	static const int MAX_THREADS = 32;
+	static const int FRAME_BUCKETS = 8;
+
+	// Upper bounds of the frame-time histogram in milliseconds; a last bucket takes the rest
+	static constexpr double FRAME_BUCKET_MS[FRAME_BUCKETS] = {1.0, 2.0, 4.0, 8.0, 16.7, 33.3, 50.0, 100.0};
+
+	using Sampler = std::function<double()>;
+
+	static Metrics& Get()
+	{
+		static Metrics metrics;
+		return metrics;
+	}
+
+	Metrics(const Metrics&) = delete;
+	Metrics& operator=(const Metrics&) = delete;
+
+	~Metrics()
+	{
+		Stop();
+	}
+
+	// Any thread
+	void Add(eMetricCounter counter, uint64_t n = 1)
+	{
+		Slot& slot = LocalSlot();
+		Bump(slot, slot.counters[counter], n);
+	}
+
+	// Any thread
+	void ObserveFrameMs(double ms)
+	{
+		Slot& slot = LocalSlot();
+		int bucket = 0;
+		while (bucket < FRAME_BUCKETS && ms > FRAME_BUCKET_MS[bucket])
+			bucket++;
+		Bump(slot, slot.frameBuckets[bucket], 1);
+		Bump(slot, slot.frameUs, (uint64_t)(ms * 1000.0));
+	}
+
+	void Set(eMetricGauge gauge, int64_t value)
+	{
+		gauges[gauge].store(value, std::memory_order_relaxed);
+	}
+
+	// Before Start. type is "counter" or "gauge".
+	void AddSampler(const char* name, const char* type, const char* help, Sampler sampler)
+	{
+		samplers.push_back({name, type, help, std::move(sampler)});
+	}
+
+	// Serves snapshots on socketPath until Stop; a stale socket file there is replaced
+	bool Start(const std::string& socketPath)
+	{
+#if defined(_WIN32)
+		std::cout << "Metrics need Unix domain sockets" << std::endl;
+		return false;
+#else
+		Stop();
+		sockaddr_un address = {};
+		address.sun_family = AF_UNIX;
+		if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path))
+		{
+			std::cout << "Metrics socket path is empty or too long: " << socketPath << std::endl;
+			return false;
+		}
+		std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+		unlink(socketPath.c_str());
+		listener = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (listener < 0 || bind(listener, (sockaddr*)&address, sizeof(address)) != 0 || listen(listener, 4) != 0)
+		{
+			std::cout << "Cannot serve metrics on " << socketPath << std::endl;
+			if (listener >= 0)
+				close(listener);
+			listener = -1;
+			return false;
+		}
+		path = socketPath;
+		stopping.store(false, std::memory_order_relaxed);
+		server = std::thread(&Metrics::Run, this);
+		std::cout << "Serving metrics on " << path << std::endl;
+		return true;
+#endif
+	}
+
+	void Stop()
+	{
+#if !defined(_WIN32)
+		if (!server.joinable())
+			return;
+		stopping.store(true, std::memory_order_relaxed);
+		server.join();
+		close(listener);
+		listener = -1;
+		unlink(path.c_str());
+#endif
+	}
+
+	// One snapshot of every metric in the Prometheus text format
+	void Write(std::ostream& out)
+	{
+		uint64_t counters[METRIC_COUNTERS] = {};
+		uint64_t buckets[FRAME_BUCKETS + 1] = {};
+		uint64_t frameUs = 0;
+		int threads = threadCount.load(std::memory_order_acquire);
+		for (int i = 0; i <= threads && i <= MAX_THREADS; i++)
+		{
+			const Slot& slot = i < threads ? *slots[i] : shared;
+			for (int c = 0; c < METRIC_COUNTERS; c++)
+				counters[c] += slot.counters[c].load(std::memory_order_relaxed);
+			for (int b = 0; b <= FRAME_BUCKETS; b++)
+				buckets[b] += slot.frameBuckets[b].load(std::memory_order_relaxed);
+			frameUs += slot.frameUs.load(std::memory_order_relaxed);
+		}
+
+		// Rates over the time since the previous snapshot
+		auto now = std::chrono::steady_clock::now();
+		double seconds = std::chrono::duration<double>(now - lastSnapshot).count();
+		double tickRate = seconds > 0.0 ? (double)(counters[METRIC_TICKS] - lastTicks) / seconds : 0.0;
+		double frameRate = seconds > 0.0 ? (double)(counters[METRIC_FRAMES] - lastFrames) / seconds : 0.0;
+		lastSnapshot = now;
+		lastTicks = counters[METRIC_TICKS];
+		lastFrames = counters[METRIC_FRAMES];
+
+		WriteMetric(out, "snake_frames_total", "counter", "Frames rendered", (double)counters[METRIC_FRAMES]);
+		WriteMetric(out, "snake_ticks_total", "counter", "Game updates that advanced the simulation", (double)counters[METRIC_TICKS]);
+		WriteMetric(out, "snake_draw_calls_total", "counter", "GL draw calls", (double)counters[METRIC_DRAW_CALLS]);
+		WriteMetric(out, "snake_frame_rate_hz", "gauge", "Frames per second since the previous snapshot", frameRate);
+		WriteMetric(out, "snake_tick_rate_hz", "gauge", "Ticks per second since the previous snapshot", tickRate);
+
+		out << "# HELP snake_frame_time_ms Time between frame starts\n# TYPE snake_frame_time_ms histogram\n";
+		uint64_t cumulative = 0;
+		for (int b = 0; b < FRAME_BUCKETS; b++)
+		{
+			cumulative += buckets[b];
+			out << "snake_frame_time_ms_bucket{le=\"" << FRAME_BUCKET_MS[b] << "\"} " << cumulative << "\n";
+		}
+		cumulative += buckets[FRAME_BUCKETS];
+		out << "snake_frame_time_ms_bucket{le=\"+Inf\"} " << cumulative << "\n";
+		out << "snake_frame_time_ms_sum " << (double)frameUs / 1000.0 << "\n";
+		out << "snake_frame_time_ms_count " << cumulative << "\n";
+
+		WriteMetric(out, "snake_length", "gauge", "Head plus tail segments", (double)gauges[GAUGE_SNAKE_LENGTH].load(std::memory_order_relaxed));
+		WriteMetric(out, "snake_score", "gauge", "Score of the current round", (double)gauges[GAUGE_SCORE].load(std::memory_order_relaxed));
+		for (const NamedSampler& sampler : samplers)
+			WriteMetric(out, sampler.name, sampler.type, sampler.help, sampler.sample());
+	}
+
+private:
+	struct alignas(64) Slot
+	{
+		std::atomic<uint64_t> counters[METRIC_COUNTERS] = {};
+		std::atomic<uint64_t> frameBuckets[FRAME_BUCKETS + 1] = {};
+		std::atomic<uint64_t> frameUs{0};
+	};
+
+	struct NamedSampler
+	{
+		const char* name;
+		const char* type;
+		const char* help;
+		Sampler sample;
+	};
+
+	Metrics() = default;
+
+	// Threads past MAX_THREADS share one slot and pay for a locked add
+	void Bump(Slot& slot, std::atomic<uint64_t>& value, uint64_t n)
+	{
+		if (&slot == &shared)
+			value.fetch_add(n, std::memory_order_relaxed);
+		else
+			value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+	}
+
+	Slot& LocalSlot()
+	{
+		static thread_local Slot* local = nullptr;
+		if (local == nullptr)
+		{
+			std::lock_guard<std::mutex> lock(registerMutex);
+			int index = threadCount.load(std::memory_order_relaxed);
+			if (index < MAX_THREADS)
+			{
+				slots[index].reset(new Slot());
+				local = slots[index].get();
+				threadCount.store(index + 1, std::memory_order_release);
+			}
+			else
+				local = &shared;
+		}
+		return *local;
+	}
+
+	static void WriteMetric(std::ostream& out, const char* name, const char* type, const char* help, double value)
+	{
+		out << "# HELP " << name << " " << help << "\n# TYPE " << name << " " << type << "\n" << name << " " << value << "\n";
+	}
+
+#if !defined(_WIN32)
+	// Server thread: polls so Stop is noticed within 100 ms
+	void Run()
+	{
+		while (!stopping.load(std::memory_order_relaxed))
+		{
+			pollfd waiting = {listener, POLLIN, 0};
+			if (poll(&waiting, 1, 100) <= 0)
+				continue;
+			int client = accept(listener, nullptr, nullptr);
+			if (client < 0)
+				continue;
+			std::ostringstream text;
+			Write(text);
+			std::string snapshot = text.str();
+			size_t sent = 0;
+			while (sent < snapshot.size())
+			{
+				ssize_t n = send(client, snapshot.data() + sent, snapshot.size() - sent, MSG_NOSIGNAL);
+				if (n <= 0)
+					break;
+				sent += (size_t)n;
+			}
+			close(client);
+		}
+	}
+#endif
+
+	std::mutex registerMutex;
+	std::unique_ptr<Slot> slots[MAX_THREADS];
+	std::atomic<int> threadCount{0};
+	Slot shared;
+	std::atomic<int64_t> gauges[METRIC_GAUGES] = {};
+	std::vector<NamedSampler> samplers;
+	std::string path;
+	int listener = -1;
+	std::atomic<bool> stopping{false};
+	std::thread server;
+	std::chrono::steady_clock::time_point lastSnapshot = std::chrono::steady_clock::now();  // Server thread
+	uint64_t lastTicks = 0, lastFrames = 0;
+};
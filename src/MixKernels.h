@@ -0,0 +1,496 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <SDL2/SDL.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define MIX_KERNELS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define MIX_TARGET_SSE2
+#define MIX_TARGET_AVX2
+#else
+#define MIX_TARGET_SSE2 __attribute__((target("sse2")))
+#define MIX_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+// **********************************************************************************************
+//	Audio Sample Kernels
+// **********************************************************************************************
+//	The inner loops of the mixer: gain and accumulate, saturate, float conversion and pitch
+//	resampling. Each kernel has a scalar version and, on x86, SSE2 and AVX2 versions compiled
+//	with per-function target attributes, so the rest of the program needs no special flags.
+//	MixKernels() checks the CPU once and returns the best table.
+//
+//	The integer kernels give bit-identical results at every level, which keeps the offline render
+//	golden hash valid on any machine. The float kernels follow the same operation order as the
+//	scalar code but are only guaranteed to match to within one LSB.
+//
+//	Resampling positions are unsigned Q16.16 frame numbers; a step of 65536 is the original pitch.
+
+enum class eSimdLevel {SCALAR = 0, SSE2, AVX2};
+
+struct MixKernelTable
+{
+	const char* name;
+	// acc[i] += (src[i] * gain) >> 15, gain in Q15
+	void (*mixAdd)(int32_t* acc, const Sint16* src, size_t samples, int32_t gain);
+	// out[i] = clamp(acc[i], -32768, 32767)
+	void (*saturate)(Sint16* out, const int32_t* acc, size_t samples);
+	// samples[i] = (samples[i] * gain) >> 15
+	void (*gain)(Sint16* samples, size_t count, int32_t gain);
+	// [-32768, 32767] to [-1, 1)
+	void (*toFloat)(float* out, const Sint16* src, size_t samples);
+	// Clamped to [-1, 1] and truncated
+	void (*fromFloat)(Sint16* out, const float* src, size_t samples);
+	// Interleaved resampling of src from position by step; returns frames written (at most frames)
+	size_t (*resampleLinear)(Sint16* out, size_t frames, const Sint16* src, size_t srcFrames, int channels, uint64_t& position, uint32_t step);
+	size_t (*resampleCubic)(Sint16* out, size_t frames, const Sint16* src, size_t srcFrames, int channels, uint64_t& position, uint32_t step);
+};
+
+// ****************************************
+//	Scalar
+// ****************************************
+
+inline void MixAddScalar(int32_t* acc, const Sint16* src, size_t samples, int32_t gain)
+{
+	for (size_t i = 0; i < samples; i++)
+		acc[i] += (src[i] * gain) >> 15;
+}
+
+inline void SaturateScalar(Sint16* out, const int32_t* acc, size_t samples)
+{
+	for (size_t i = 0; i < samples; i++)
+		out[i] = (Sint16)std::clamp(acc[i], -32768, 32767);
+}
+
+inline void GainScalar(Sint16* samples, size_t count, int32_t gain)
+{
+	for (size_t i = 0; i < count; i++)
+		samples[i] = (Sint16)std::clamp((samples[i] * gain) >> 15, -32768, 32767);
+}
+
+inline void ToFloatScalar(float* out, const Sint16* src, size_t samples)
+{
+	for (size_t i = 0; i < samples; i++)
+		out[i] = (float)src[i] * (1.0f / 32768.0f);
+}
+
+inline void FromFloatScalar(Sint16* out, const float* src, size_t samples)
+{
+	for (size_t i = 0; i < samples; i++)
+		out[i] = (Sint16)(int32_t)(std::min(std::max(src[i], -1.0f), 1.0f) * 32767.0f);
+}
+
+// Q14 weights so both products fit the 16-bit multiply-add used by the SIMD versions
+inline Sint16 LerpSample(int32_t a, int32_t b, uint64_t position)
+{
+	int32_t w1 = (int32_t)((position & 0xFFFF) >> 2);
+	return (Sint16)((a * (16384 - w1) + b * w1) >> 14);
+}
+
+inline size_t ResampleLinearScalar(Sint16* out, size_t frames, const Sint16* src, size_t srcFrames, int channels, uint64_t& position, uint32_t step)
+{
+	size_t f = 0;
+	for (; f < frames && (position >> 16) < srcFrames; f++, position += step)
+	{
+		size_t index = (size_t)(position >> 16);
+		size_t next = index + 1 < srcFrames ? index + 1 : index;
+		for (int c = 0; c < channels; c++)
+			out[f * channels + c] = LerpSample(src[index * channels + c], src[next * channels + c], position);
+	}
+	return f;
+}
+
+// Catmull-Rom through p0..p3 at t in [0, 1)
+inline float CubicSample(float p0, float p1, float p2, float p3, float t)
+{
+	float a = 3.0f * (p1 - p2) + p3 - p0;
+	float b = 2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3;
+	float c = p2 - p0;
+	float y = p1 + 0.5f * t * (c + t * (b + t * a));
+	return std::min(std::max(y, -32768.0f), 32767.0f);
+}
+
+inline size_t ResampleCubicScalar(Sint16* out, size_t frames, const Sint16* src, size_t srcFrames, int channels, uint64_t& position, uint32_t step)
+{
+	size_t f = 0;
+	for (; f < frames && (position >> 16) < srcFrames; f++, position += step)
+	{
+		size_t i1 = (size_t)(position >> 16);
+		size_t i0 = i1 > 0 ? i1 - 1 : 0;
+		size_t i2 = std::min(i1 + 1, srcFrames - 1);
+		size_t i3 = std::min(i1 + 2, srcFrames - 1);
+		float t = (float)(position & 0xFFFF) * (1.0f / 65536.0f);
+		for (int c = 0; c < channels; c++)
+		{
+			out[f * channels + c] = (Sint16)(int32_t)CubicSample(src[i0 * channels + c], src[i1 * channels + c],
+				src[i2 * channels + c], src[i3 * channels + c], t);
+		}
+	}
+	return f;
+}
+
+// ****************************************
+//	SSE2 / AVX2
+// ****************************************
+#if defined(MIX_KERNELS_X86)
+
+MIX_TARGET_SSE2 inline void MixAddSse2(int32_t* acc, const Sint16* src, size_t samples, int32_t gain)
+{
+	size_t i = 0;
+	__m128i g = _mm_set1_epi16((short)gain);
+	for (; i + 8 <= samples; i += 8)
+	{
+		// The low and high halves of the 16x16 products interleave into exact 32-bit products
+		__m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+		__m128i lo = _mm_mullo_epi16(s, g);
+		__m128i hi = _mm_mulhi_epi16(s, g);
+		__m128i p0 = _mm_srai_epi32(_mm_unpacklo_epi16(lo, hi), 15);
+		__m128i p1 = _mm_srai_epi32(_mm_unpackhi_epi16(lo, hi), 15);
+		_mm_storeu_si128((__m128i*)(acc + i), _mm_add_epi32(_mm_loadu_si128((const __m128i*)(acc + i)), p0));
+		_mm_storeu_si128((__m128i*)(acc + i + 4), _mm_add_epi32(_mm_loadu_si128((const __m128i*)(acc + i + 4)), p1));
+	}
+	MixAddScalar(acc + i, src + i, samples - i, gain);
+}
+
+MIX_TARGET_SSE2 inline void SaturateSse2(Sint16* out, const int32_t* acc, size_t samples)
+{
+	size_t i = 0;
+	for (; i + 8 <= samples; i += 8)
+	{
+		__m128i a = _mm_loadu_si128((const __m128i*)(acc + i));
+		__m128i b = _mm_loadu_si128((const __m128i*)(acc + i + 4));
+		_mm_storeu_si128((__m128i*)(out + i), _mm_packs_epi32(a, b));
+	}
+	SaturateScalar(out + i, acc + i, samples - i);
+}
+
+MIX_TARGET_SSE2 inline void GainSse2(Sint16* samples, size_t count, int32_t gain)
+{
+	size_t i = 0;
+	__m128i g = _mm_set1_epi16((short)gain);
+	for (; i + 8 <= count; i += 8)
+	{
+		__m128i s = _mm_loadu_si128((const __m128i*)(samples + i));
+		__m128i lo = _mm_mullo_epi16(s, g);
+		__m128i hi = _mm_mulhi_epi16(s, g);
+		__m128i p0 = _mm_srai_epi32(_mm_unpacklo_epi16(lo, hi), 15);
+		__m128i p1 = _mm_srai_epi32(_mm_unpackhi_epi16(lo, hi), 15);
+		_mm_storeu_si128((__m128i*)(samples + i), _mm_packs_epi32(p0, p1));
+	}
+	GainScalar(samples + i, count - i, gain);
+}
+
+MIX_TARGET_SSE2 inline void ToFloatSse2(float* out, const Sint16* src, size_t samples)
+{
+	size_t i = 0;
+	__m128 scale = _mm_set1_ps(1.0f / 32768.0f);
+	for (; i + 8 <= samples; i += 8)
+	{
+		__m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+		// Sign-extend by unpacking into the high half and shifting back down
+		__m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16);
+		__m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16);
+		_mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+		_mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+	}
+	ToFloatScalar(out + i, src + i, samples - i);
+}
+
+MIX_TARGET_SSE2 inline void FromFloatSse2(Sint16* out, const float* src, size_t samples)
+{
+	size_t i = 0;
+	__m128 lower = _mm_set1_ps(-1.0f), upper = _mm_set1_ps(1.0f), scale = _mm_set1_ps(32767.0f);
+	for (; i + 8 <= samples; i += 8)
+	{
+		__m128 a = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i), lower), upper);
+		__m128 b = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i + 4), lower), upper);
+		__m128i ia = _mm_cvttps_epi32(_mm_mul_ps(a, scale));
+		__m128i ib = _mm_cvttps_epi32(_mm_mul_ps(b, scale));
+		_mm_storeu_si128((__m128i*)(out + i), _mm_packs_epi32(ia, ib));
+	}
+	FromFloatScalar(out + i, src + i, samples - i);
+}
+
+// Each output sample's (a, b) source pair sits next to its Q14 weight pair, so the interpolation
+// is a single multiply-add. Mono and stereo are the layouts the device opens; others use the
+// scalar loop.
+MIX_TARGET_SSE2 inline __m128i LoadStereoPairsSse2(const Sint16* src, size_t index)
+{
+	// aL aR bL bR -> aL bL aR bR
+	__m128i frames = _mm_loadl_epi64((const __m128i*)(src + index * 2));
+	return _mm_shufflelo_epi16(frames, _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+MIX_TARGET_SSE2 inline size_t ResampleLinearSse2(Sint16* out, size_t frames, const Sint16* src, size_t srcFrames, int channels, uint64_t& position, uint32_t step)
+{
+	if (channels > 2)
+		return ResampleLinearScalar(out, frames, src, srcFrames, channels, position, step);
+
+	size_t f = 0;
+	const size_t perVector = 4 / channels;
+	// The last source frame has no successor, leave it to the scalar tail
+	while (f + perVector <= frames && ((position + (uint64_t)step * (perVector - 1)) >> 16) + 1 < srcFrames)
+	{
+		// Built in registers; storing lanes to memory and reloading them stalls store forwarding
+		auto weight = [&](size_t k) {
+			int32_t w1 = (int32_t)(((position + (uint64_t)step * k) & 0xFFFF) >> 2);
+			return (16384 - w1) | (w1 << 16);
+		};
+		auto index = [&](size_t k) { return (size_t)((position + (uint64_t)step * k) >> 16); };
+		__m128i pairs, weights;
+		if (channels == 1)
+		{
+			int32_t p[4];
+			for (size_t k = 0; k < 4; k++)
+				std::memcpy(&p[k], src + index(k), sizeof(int32_t));
+			pairs = _mm_set_epi32(p[3], p[2], p[1], p[0]);
+			weights = _mm_set_epi32(weight(3), weight(2), weight(1), weight(0));
+		}
+		else
+		{
+			pairs = _mm_unpacklo_epi64(LoadStereoPairsSse2(src, index(0)), LoadStereoPairsSse2(src, index(1)));
+			weights = _mm_set_epi32(weight(1), weight(1), weight(0), weight(0));
+		}
+		__m128i v = _mm_srai_epi32(_mm_madd_epi16(pairs, weights), 14);
+		_mm_storel_epi64((__m128i*)(out + f * channels), _mm_packs_epi32(v, v));
+		f += perVector;
+		position += (uint64_t)step * perVector;
+	}
+	return f + ResampleLinearScalar(out + f * channels, frames - f, src, srcFrames, channels, position, step);
+}
+
+// Four consecutive source frames around each position, widened to float
+MIX_TARGET_SSE2 inline void LoadTapsSse2(const Sint16* src, size_t first, int channels, __m128& lo, __m128& hi)
+{
+	__m128i s = channels == 1 ? _mm_loadl_epi64((const __m128i*)(src + first)) : _mm_loadu_si128((const __m128i*)(src + first * 2));
+	lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16));
+	hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16));
+}
+
+// The taps are transposed so each vector holds one tap for four output samples; the Horner
+// evaluation is then the scalar CubicSample, operation for operation.
+MIX_TARGET_SSE2 inline size_t ResampleCubicSse2(Sint16* out, size_t frames, const Sint16* src, size_t srcFrames, int channels, uint64_t& position, uint32_t step)
+{
+	if (channels > 2)
+		return ResampleCubicScalar(out, frames, src, srcFrames, channels, position, step);
+
+	size_t f = 0;
+	// The first source frame has no predecessor, start the vector loop after it
+	while (f < frames && (position >> 16) == 0)
+	{
+		size_t written = ResampleCubicScalar(out + f * channels, 1, src, srcFrames, channels, position, step);
+		if (written == 0)
+			return f;
+		f += written;
+	}
+
+	const __m128 three = _mm_set1_ps(3.0f), two = _mm_set1_ps(2.0f), five = _mm_set1_ps(5.0f);
+	const __m128 four = _mm_set1_ps(4.0f), half = _mm_set1_ps(0.5f);
+	const __m128 lower = _mm_set1_ps(-32768.0f), upper = _mm_set1_ps(32767.0f);
+	const __m128 toUnit = _mm_set1_ps(1.0f / 65536.0f);
+	const size_t perVector = 4 / channels;
+	while (f + perVector <= frames && ((position + (uint64_t)step * (perVector - 1)) >> 16) + 2 < srcFrames)
+	{
+		__m128 p0, p1, p2, p3, tv;
+		if (channels == 1)
+		{
+			__m128 rows[4], unused;
+			int32_t fraction[4];
+			for (size_t k = 0; k < 4; k++)
+			{
+				uint64_t at = position + (uint64_t)step * k;
+				LoadTapsSse2(src, (size_t)(at >> 16) - 1, 1, rows[k], unused);
+				fraction[k] = (int32_t)(at & 0xFFFF);
+			}
+			_MM_TRANSPOSE4_PS(rows[0], rows[1], rows[2], rows[3]);
+			p0 = rows[0];
+			p1 = rows[1];
+			p2 = rows[2];
+			p3 = rows[3];
+			tv = _mm_set_ps((float)fraction[3], (float)fraction[2], (float)fraction[1], (float)fraction[0]);
+		}
+		else
+		{
+			__m128 aLo, aHi, bLo, bHi;
+			uint64_t next = position + step;
+			LoadTapsSse2(src, (size_t)(position >> 16) - 1, 2, aLo, aHi);
+			LoadTapsSse2(src, (size_t)(next >> 16) - 1, 2, bLo, bHi);
+			p0 = _mm_movelh_ps(aLo, bLo);
+			p1 = _mm_movehl_ps(bLo, aLo);
+			p2 = _mm_movelh_ps(aHi, bHi);
+			p3 = _mm_movehl_ps(bHi, aHi);
+			float ta = (float)(position & 0xFFFF), tb = (float)(next & 0xFFFF);
+			tv = _mm_set_ps(tb, tb, ta, ta);
+		}
+		tv = _mm_mul_ps(tv, toUnit);
+
+		__m128 a = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(three, _mm_sub_ps(p1, p2)), p3), p0);
+		__m128 b = _mm_sub_ps(_mm_add_ps(_mm_sub_ps(_mm_mul_ps(two, p0), _mm_mul_ps(five, p1)), _mm_mul_ps(four, p2)), p3);
+		__m128 c = _mm_sub_ps(p2, p0);
+		__m128 y = _mm_add_ps(p1, _mm_mul_ps(_mm_mul_ps(half, tv), _mm_add_ps(c, _mm_mul_ps(tv, _mm_add_ps(b, _mm_mul_ps(tv, a))))));
+		y = _mm_min_ps(_mm_max_ps(y, lower), upper);
+		__m128i v = _mm_cvttps_epi32(y);
+		_mm_storel_epi64((__m128i*)(out + f * channels), _mm_packs_epi32(v, v));
+		f += perVector;
+		position += (uint64_t)step * perVector;
+	}
+	return f + ResampleCubicScalar(out + f * channels, frames - f, src, srcFrames, channels, position, step);
+}
+
+MIX_TARGET_AVX2 inline void MixAddAvx2(int32_t* acc, const Sint16* src, size_t samples, int32_t gain)
+{
+	size_t i = 0;
+	__m256i g = _mm256_set1_epi32(gain);
+	for (; i + 16 <= samples; i += 16)
+	{
+		__m256i s0 = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(src + i)));
+		__m256i s1 = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(src + i + 8)));
+		__m256i p0 = _mm256_srai_epi32(_mm256_mullo_epi32(s0, g), 15);
+		__m256i p1 = _mm256_srai_epi32(_mm256_mullo_epi32(s1, g), 15);
+		_mm256_storeu_si256((__m256i*)(acc + i), _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(acc + i)), p0));
+		_mm256_storeu_si256((__m256i*)(acc + i + 8), _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(acc + i + 8)), p1));
+	}
+	MixAddScalar(acc + i, src + i, samples - i, gain);
+}
+
+MIX_TARGET_AVX2 inline void SaturateAvx2(Sint16* out, const int32_t* acc, size_t samples)
+{
+	size_t i = 0;
+	for (; i + 16 <= samples; i += 16)
+	{
+		__m256i a = _mm256_loadu_si256((const __m256i*)(acc + i));
+		__m256i b = _mm256_loadu_si256((const __m256i*)(acc + i + 8));
+		// packs works per 128-bit lane; the permute puts the four quarters back in order
+		__m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), 0xD8);
+		_mm256_storeu_si256((__m256i*)(out + i), packed);
+	}
+	SaturateScalar(out + i, acc + i, samples - i);
+}
+
+MIX_TARGET_AVX2 inline void GainAvx2(Sint16* samples, size_t count, int32_t gain)
+{
+	size_t i = 0;
+	__m256i g = _mm256_set1_epi32(gain);
+	for (; i + 16 <= count; i += 16)
+	{
+		__m256i s0 = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(samples + i)));
+		__m256i s1 = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(samples + i + 8)));
+		__m256i p0 = _mm256_srai_epi32(_mm256_mullo_epi32(s0, g), 15);
+		__m256i p1 = _mm256_srai_epi32(_mm256_mullo_epi32(s1, g), 15);
+		_mm256_storeu_si256((__m256i*)(samples + i), _mm256_permute4x64_epi64(_mm256_packs_epi32(p0, p1), 0xD8));
+	}
+	GainScalar(samples + i, count - i, gain);
+}
+
+MIX_TARGET_AVX2 inline void ToFloatAvx2(float* out, const Sint16* src, size_t samples)
+{
+	size_t i = 0;
+	__m256 scale = _mm256_set1_ps(1.0f / 32768.0f);
+	for (; i + 8 <= samples; i += 8)
+	{
+		__m256i s = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(src + i)));
+		_mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(s), scale));
+	}
+	ToFloatScalar(out + i, src + i, samples - i);
+}
+
+MIX_TARGET_AVX2 inline void FromFloatAvx2(Sint16* out, const float* src, size_t samples)
+{
+	size_t i = 0;
+	__m256 lower = _mm256_set1_ps(-1.0f), upper = _mm256_set1_ps(1.0f), scale = _mm256_set1_ps(32767.0f);
+	for (; i + 16 <= samples; i += 16)
+	{
+		__m256 a = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(src + i), lower), upper);
+		__m256 b = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(src + i + 8), lower), upper);
+		__m256i ia = _mm256_cvttps_epi32(_mm256_mul_ps(a, scale));
+		__m256i ib = _mm256_cvttps_epi32(_mm256_mul_ps(b, scale));
+		_mm256_storeu_si256((__m256i*)(out + i), _mm256_permute4x64_epi64(_mm256_packs_epi32(ia, ib), 0xD8));
+	}
+	FromFloatScalar(out + i, src + i, samples - i);
+}
+
+// Mono only: one 32-bit gather fetches each lane's adjacent (a, b) pair directly
+MIX_TARGET_AVX2 inline size_t ResampleLinearAvx2(Sint16* out, size_t frames, const Sint16* src, size_t srcFrames, int channels, uint64_t& position, uint32_t step)
+{
+	if (channels != 1)
+		return ResampleLinearSse2(out, frames, src, srcFrames, channels, position, step);
+
+	size_t f = 0;
+	const __m256i mask = _mm256_set1_epi32(0xFFFF);
+	const __m256i q14 = _mm256_set1_epi32(16384);
+	while (f + 8 <= frames && ((position + (uint64_t)step * 7) >> 16) + 1 < srcFrames)
+	{
+		alignas(32) int32_t index[8], w1[8];
+		for (int k = 0; k < 8; k++)
+		{
+			uint64_t at = position + (uint64_t)step * k;
+			index[k] = (int32_t)(at >> 16);
+			w1[k] = (int32_t)((at & 0xFFFF) >> 2);
+		}
+		__m256i pairs = _mm256_i32gather_epi32((const int*)src, _mm256_load_si256((const __m256i*)index), 2);
+		__m256i high = _mm256_load_si256((const __m256i*)w1);
+		__m256i weights = _mm256_or_si256(_mm256_and_si256(_mm256_sub_epi32(q14, high), mask), _mm256_slli_epi32(high, 16));
+		__m256i v = _mm256_srai_epi32(_mm256_madd_epi16(pairs, weights), 14);
+		v = _mm256_permute4x64_epi64(_mm256_packs_epi32(v, v), 0xD8);
+		_mm_storeu_si128((__m128i*)(out + f), _mm256_castsi256_si128(v));
+		f += 8;
+		position += (uint64_t)step * 8;
+	}
+	return f + ResampleLinearScalar(out + f, frames - f, src, srcFrames, channels, position, step);
+}
+
+inline bool CpuHasAvx2()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7)
+		return false;
+	__cpuidex(info, 7, 0);
+	bool avx2 = (info[1] & (1 << 5)) != 0;
+	__cpuid(info, 1);
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	return avx2 && osxsave && (_xgetbv(0) & 6) == 6;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif
+
+// Returns the kernels for a level, or nullptr if this CPU or build cannot run them
+inline const MixKernelTable* MixKernelsFor(eSimdLevel level)
+{
+	static const MixKernelTable scalar = {"scalar", MixAddScalar, SaturateScalar, GainScalar,
+		ToFloatScalar, FromFloatScalar, ResampleLinearScalar, ResampleCubicScalar};
+#if defined(MIX_KERNELS_X86)
+	static const MixKernelTable sse2 = {"sse2", MixAddSse2, SaturateSse2, GainSse2,
+		ToFloatSse2, FromFloatSse2, ResampleLinearSse2, ResampleCubicSse2};
+	static const MixKernelTable avx2 = {"avx2", MixAddAvx2, SaturateAvx2, GainAvx2,
+		ToFloatAvx2, FromFloatAvx2, ResampleLinearAvx2, ResampleCubicSse2};
+	static const bool hasAvx2 = CpuHasAvx2();
+	if (level == eSimdLevel::AVX2)
+		return hasAvx2 ? &avx2 : nullptr;
+	if (level == eSimdLevel::SSE2)
+		return &sse2;
+#else
+	if (level != eSimdLevel::SCALAR)
+		return nullptr;
+#endif
+	return &scalar;
+}
+
+// Best kernels for this CPU, chosen on first use
+inline const MixKernelTable& MixKernels()
+{
+	static const MixKernelTable* best = MixKernelsFor(eSimdLevel::AVX2) ? MixKernelsFor(eSimdLevel::AVX2)
+		: (MixKernelsFor(eSimdLevel::SSE2) ? MixKernelsFor(eSimdLevel::SSE2) : MixKernelsFor(eSimdLevel::SCALAR));
+	return *best;
+}
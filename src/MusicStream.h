@@ -0,0 +1,214 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <SDL2/SDL.h>
+#include "AudioMixer.h"
+#include "MappedFile.h"
+#include "Profiler.h"
+#include "WavFile.h"
+
+// **********************************************************************************************
+//	Streaming Music Player
+// **********************************************************************************************
+//	The track is memory-mapped, never loaded. A background thread converts it to the device
+//	format in small chunks and writes into a lock-free single-producer single-consumer ring;
+//	the mixer reads from the ring inside the audio callback. Memory use is the ring plus one
+//	chunk, whatever the length of the track.
+//
+//	The decoder sleeps while the ring holds more than lowWater samples and then refills it to
+//	the top, so the callback always has at least lowWater samples of prefetched audio. When the
+//	ring runs dry before the end of the track the callback plays silence and counts an underrun.
+
+class MusicStream : public StreamSource
+{
+public:
+	static const size_t RING_FRAMES = 16384;    // ~370 ms at 44.1 kHz
+	static const size_t CHUNK_BYTES = 8192;     // Source bytes converted per step
+
+	~MusicStream() override
+	{
+		Stop();
+	}
+
+	bool Open(const char* path, const SDL_AudioSpec& device, bool loopTrack = true)
+	{
+		Stop();
+		if (!file.Open(path))
+		{
+			std::cout << "Failed to open music: " << path << std::endl;
+			return false;
+		}
+		if (!ParseWav(file.Data(), file.Size(), track))
+		{
+			std::cout << "Unsupported music file: " << path << std::endl;
+			file.Close();
+			return false;
+		}
+
+		converter = SDL_NewAudioStream(track.spec.format, track.spec.channels, track.spec.freq,
+			device.format, device.channels, device.freq);
+		if (converter == nullptr)
+		{
+			std::cout << "Failed to create music converter: " << SDL_GetError() << std::endl;
+			file.Close();
+			return false;
+		}
+
+		name = path;
+		loop = loopTrack;
+		channels = device.channels;
+		size_t capacity = 1;
+		while (capacity < RING_FRAMES * channels)
+			capacity <<= 1;
+		ring.assign(capacity, 0);
+		mask = ring.size() - 1;
+		// Whole frames only, so every write ends on a frame boundary whatever the channel count
+		frameCapacity = ring.size() / channels * channels;
+		lowWater = frameCapacity / 2;
+		chunk.resize(CHUNK_BYTES * 4);
+		cursor = 0;
+		readIndex.store(0);
+		writeIndex.store(0);
+		finished.store(false);
+		return true;
+	}
+
+	void Start()
+	{
+		if (converter == nullptr || running.load())
+			return;
+		running.store(true);
+		decoder = std::thread(&MusicStream::DecodeLoop, this);
+	}
+
+	// Stop the mixer from reading (SetMusic(nullptr) or close the device) before calling this
+	void Stop()
+	{
+		running.store(false);
+		if (decoder.joinable())
+			decoder.join();
+		if (converter)
+			SDL_FreeAudioStream(converter);
+		converter = nullptr;
+		file.Close();
+	}
+
+	// Audio thread
+	int Read(Sint16* out, int samples) override
+	{
+		size_t read = readIndex.load(std::memory_order_relaxed);
+		size_t available = writeIndex.load(std::memory_order_acquire) - read;
+		size_t count = std::min(available, (size_t)samples);
+
+		for (size_t i = 0; i < count; i++)
+			out[i] = ring[(read + i) & mask];
+		readIndex.store(read + count, std::memory_order_release);
+
+		if (count < (size_t)samples)
+		{
+			std::fill(out + count, out + samples, (Sint16)0);
+			if (!finished.load(std::memory_order_acquire))
+				underruns.fetch_add(1, std::memory_order_relaxed);
+		}
+		return (int)count;
+	}
+
+	void Report(std::ostream& out) const
+	{
+		out << "[Music] " << name << ": " << track.bytes << " source bytes, ring "
+			<< ring.size() * sizeof(Sint16) << " bytes, decoded " << decodedBytes.load()
+			<< " bytes, underruns " << underruns.load() << "\n";
+	}
+
+	[[nodiscard]] uint64_t Underruns() const
+	{
+		return underruns.load(std::memory_order_relaxed);
+	}
+
+private:
+	void DecodeLoop()
+	{
+		Profiler::Get().NameThread("music decoder");
+		while (running.load(std::memory_order_relaxed))
+		{
+			size_t write = writeIndex.load(std::memory_order_relaxed);
+			size_t fill = write - readIndex.load(std::memory_order_acquire);
+			if (fill > lowWater || finished.load(std::memory_order_relaxed))
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(2));
+				continue;
+			}
+
+			// Refill to the top of the ring
+			PROFILE_SCOPE("music decode");
+			while (fill < frameCapacity && running.load(std::memory_order_relaxed))
+			{
+				if (SDL_AudioStreamAvailable(converter) == 0 && !FeedConverter())
+				{
+					finished.store(true, std::memory_order_release);
+					break;
+				}
+
+				// SDL_AudioStreamGet returns nothing for a request that is not whole frames
+				size_t space = std::min(frameCapacity - fill, chunk.size() / sizeof(Sint16));
+				space -= space % channels;
+				if (space == 0)
+					break;
+				int got = SDL_AudioStreamGet(converter, chunk.data(), (int)(space * sizeof(Sint16)));
+				if (got <= 0)
+					continue;
+
+				const Sint16* samples = (const Sint16*)chunk.data();
+				size_t count = (size_t)got / sizeof(Sint16);
+				for (size_t i = 0; i < count; i++)
+					ring[(write + i) & mask] = samples[i];
+				write += count;
+				fill += count;
+				writeIndex.store(write, std::memory_order_release);
+				decodedBytes.fetch_add((uint64_t)got, std::memory_order_relaxed);
+			}
+		}
+	}
+
+	// Pushes the next chunk of the mapped track into the converter; false at the end of a non-looping track
+	bool FeedConverter()
+	{
+		if (cursor >= track.bytes)
+		{
+			if (!loop)
+			{
+				SDL_AudioStreamFlush(converter);
+				return SDL_AudioStreamAvailable(converter) > 0;
+			}
+			cursor = 0;
+		}
+		size_t count = std::min<size_t>(CHUNK_BYTES, track.bytes - cursor);
+		SDL_AudioStreamPut(converter, track.pcm + cursor, (int)count);
+		cursor += count;
+		return true;
+	}
+
+	MappedFile file;
+	WavInfo track{};
+	SDL_AudioStream* converter = nullptr;
+	std::string name;
+	bool loop = true;
+	int channels = 2;
+	size_t cursor = 0;
+
+	std::vector<Sint16> ring;
+	size_t mask = 0, lowWater = 0;
+	size_t frameCapacity = 0;           // Samples of the ring in use, a multiple of channels
+	std::vector<Uint8> chunk;
+	std::atomic<size_t> readIndex{0}, writeIndex{0};
+
+	std::thread decoder;
+	std::atomic<bool> running{false}, finished{false};
+	std::atomic<uint64_t> underruns{0}, decodedBytes{0};
+};
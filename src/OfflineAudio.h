@@ -0,0 +1,215 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "AudioMixer.h"
+#include "ChipSynth.h"
+#include "GameState.h"
+#include "MappedFile.h"
+#include "WavFile.h"
+
+// **********************************************************************************************
+//	Offline Audio Rendering
+// **********************************************************************************************
+//	Renders the game's sound output without an audio device. The AudioMixer is driven by the
+//	simulation clock: every StepGame tick mixes exactly the frames that tick covers, and sounds
+//	start on the tick whose events triggered them. Clip conversion uses the integer code below
+//	instead of SDL's resampler, so the output is bit-identical on every machine and SDL version.
+
+// Decodes 8/16/32-bit integer or float PCM to signed 16-bit, remaps channels and resamples linearly
+inline std::vector<Sint16> ConvertPcm(const WavInfo& wav, int rate, int channels)
+{
+	int sourceChannels = wav.spec.channels;
+	int bytesPerSample = SDL_AUDIO_BITSIZE(wav.spec.format) / 8;
+	size_t sourceFrames = wav.bytes / ((size_t)bytesPerSample * sourceChannels);
+
+	auto sample = [&](size_t frame, int channel) -> int32_t {
+		const uint8_t* p = wav.pcm + (frame * sourceChannels + channel % sourceChannels) * bytesPerSample;
+		if (wav.spec.format == AUDIO_U8)
+			return ((int32_t)p[0] - 128) << 8;
+		if (wav.spec.format == AUDIO_S16LSB)
+			return (int16_t)ReadLE16(p);
+		if (wav.spec.format == AUDIO_S32LSB)
+			return (int32_t)ReadLE32(p) >> 16;
+		uint32_t bits = ReadLE32(p);
+		float f;
+		std::memcpy(&f, &bits, sizeof(f));
+		f = f < -1.0f ? -1.0f : (f > 1.0f ? 1.0f : f);
+		return (int32_t)(f * 32767.0f);
+	};
+
+	// 32.32 fixed-point step keeps the resampler exact and platform independent
+	uint64_t step = ((uint64_t)wav.spec.freq << 32) / (uint64_t)rate;
+	size_t frames = sourceFrames == 0 ? 0 : (size_t)((((uint64_t)(sourceFrames - 1)) << 32) / step) + 1;
+	std::vector<Sint16> out(frames * channels);
+	uint64_t position = 0;
+	for (size_t f = 0; f < frames; f++, position += step)
+	{
+		size_t index = (size_t)(position >> 32);
+		int64_t fraction = (int64_t)((position >> 16) & 0xFFFF);
+		size_t next = index + 1 < sourceFrames ? index + 1 : index;
+		for (int c = 0; c < channels; c++)
+		{
+			int32_t a, b;
+			// Mono to many: copy; many to mono: average the first two
+			if (channels == 1 && sourceChannels > 1)
+			{
+				a = (sample(index, 0) + sample(index, 1)) / 2;
+				b = (sample(next, 0) + sample(next, 1)) / 2;
+			}
+			else
+			{
+				a = sample(index, c);
+				b = sample(next, c);
+			}
+			out[f * channels + c] = (Sint16)(a + (((b - a) * fraction) >> 16));
+		}
+	}
+	return out;
+}
+
+inline bool WriteWav(const char* path, const std::vector<Sint16>& samples, int rate, int channels)
+{
+	FILE* file = std::fopen(path, "wb");
+	if (!file)
+		return false;
+
+	uint32_t dataBytes = (uint32_t)(samples.size() * sizeof(Sint16));
+	uint8_t header[44];
+	auto put32 = [&](int at, uint32_t v) { for (int i = 0; i < 4; i++) header[at + i] = (uint8_t)(v >> (8 * i)); };
+	auto put16 = [&](int at, uint16_t v) { header[at] = (uint8_t)v; header[at + 1] = (uint8_t)(v >> 8); };
+	std::memcpy(header, "RIFF", 4);
+	put32(4, 36 + dataBytes);
+	std::memcpy(header + 8, "WAVEfmt ", 8);
+	put32(16, 16);
+	put16(20, 1);
+	put16(22, (uint16_t)channels);
+	put32(24, (uint32_t)rate);
+	put32(28, (uint32_t)(rate * channels * sizeof(Sint16)));
+	put16(32, (uint16_t)(channels * sizeof(Sint16)));
+	put16(34, 16);
+	std::memcpy(header + 36, "data", 4);
+	put32(40, dataBytes);
+
+	// Samples are written little-endian whatever the host order
+	bool ok = std::fwrite(header, sizeof(header), 1, file) == 1;
+	for (size_t i = 0; ok && i < samples.size(); i++)
+	{
+		uint8_t bytes[2] = {(uint8_t)((uint16_t)samples[i] & 0xFF), (uint8_t)((uint16_t)samples[i] >> 8)};
+		ok = std::fwrite(bytes, 2, 1, file) == 1;
+	}
+	return (std::fclose(file) == 0) && ok;
+}
+
+// FNV-1a over the rendered samples, used as the golden value
+inline uint64_t HashSamples(const std::vector<Sint16>& samples)
+{
+	uint64_t hash = 0xCBF29CE484222325ull;
+	for (Sint16 s : samples)
+	{
+		hash = (hash ^ (uint8_t)((uint16_t)s & 0xFF)) * 0x100000001B3ull;
+		hash = (hash ^ (uint8_t)((uint16_t)s >> 8)) * 0x100000001B3ull;
+	}
+	return hash;
+}
+
+class OfflineAudioRenderer
+{
+public:
+	OfflineAudioRenderer(int rate = 44100, int channels = 2) : rate(rate), channels(channels)
+	{
+		mixer.SetFormat(channels, 4096, rate);
+	}
+
+	// Loads and converts a WAV; clip ids follow load order like Global::audioSources
+	bool LoadClip(const char* path)
+	{
+		MappedFile file;
+		WavInfo wav;
+		if (!file.Open(path) || !ParseWav(file.Data(), file.Size(), wav))
+			return false;
+		clips.push_back(ConvertPcm(wav, rate, channels));
+		mixer.AddClip(clips.back().data(), (Uint32)(clips.back().size() / channels));
+		return true;
+	}
+
+	// Generates the effects with the ChipSynth instead of the loaded clips
+	void UseSynth()
+	{
+		synth.SetFormat(channels, rate);
+		mixer.SetStream(STREAM_SYNTH, &synth, 1.0f);
+		useSynth = true;
+	}
+
+	// Starts a sound at the current simulation time
+	void Play(int clip, float gain = 1.0f, float pitch = 1.0f)
+	{
+		mixer.Play(clip, gain, pitch);
+	}
+
+	// Mixes the frames covered by the next tick of tickMs milliseconds
+	void AdvanceTick(uint32_t tickMs)
+	{
+		elapsedMs += tickMs;
+		uint64_t target = elapsedMs * (uint64_t)rate / 1000;
+		int frames = (int)(target - renderedFrames);
+		if (frames <= 0)
+			return;
+		size_t start = output.size();
+		output.resize(start + (size_t)frames * channels);
+		mixer.Mix(output.data() + start, frames);
+		renderedFrames = target;
+	}
+
+	// Feeds StepGame events to the mixer the way UpdateGame does (clip 0 eat, clip 1 game over)
+	void HandleEvents(int events, eDifficulty difficulty = eDifficulty::EASY)
+	{
+		if (useSynth)
+		{
+			if (events & EVENT_ATE_FRUIT)
+				synth.Trigger(EAT_PATCH, EffectPitch(difficulty));
+			if (events & EVENT_GAME_OVER)
+				synth.Trigger(GAME_OVER_PATCH);
+			return;
+		}
+		if (events & EVENT_ATE_FRUIT)
+			Play(0, 1.0f, EffectPitch(difficulty));
+		if ((events & EVENT_GAME_OVER) && clips.size() > 1)
+			Play(1);
+	}
+
+	[[nodiscard]] const std::vector<Sint16>& Output() const
+	{
+		return output;
+	}
+
+	[[nodiscard]] int Rate() const
+	{
+		return rate;
+	}
+
+	[[nodiscard]] int Channels() const
+	{
+		return channels;
+	}
+
+	// Bytes held by the converted clips
+	[[nodiscard]] size_t ClipBytes() const
+	{
+		size_t bytes = 0;
+		for (const std::vector<Sint16>& clip : clips)
+			bytes += clip.size() * sizeof(Sint16);
+		return bytes;
+	}
+
+	AudioMixer mixer;
+	ChipSynth synth;
+
+private:
+	bool useSynth = false;
+	int rate, channels;
+	std::vector<std::vector<Sint16>> clips;
+	std::vector<Sint16> output;
+	uint64_t elapsedMs = 0, renderedFrames = 0;
+};
@@ -0,0 +1,221 @@
+#pragma once
+#include <vector>
+#include "Autopilot.h"
+#include "Grid.h"
+
+// **********************************************************************************************
+//	Pathfinding Autopilot
+// **********************************************************************************************
+//	Breadth-first search on the BoardGrid. Everything a search needs is allocated once: the
+//	open list is a fixed ring of cells, and visited marks are generation stamps, so starting a
+//	new search is a single increment instead of a clear.
+//
+//	Before taking the shortest path to the fruit the bot checks that, once it gets there, its
+//	head can still reach its tail end. If not, it follows its own tail, and failing that it
+//	moves towards the largest open area.
+
+class PathAutopilot : public Autopilot
+{
+public:
+	explicit PathAutopilot(int width = 28, int height = 28)
+		: grid(width, height), blocked(grid.Cells()), stamp(grid.Cells(), 0), parent(grid.Cells(), -1)
+	{
+		open.resize(grid.Cells());
+		path.reserve(grid.Cells());
+		body.reserve(grid.Cells() + MAX_TAIL_SEGMENTS + 1);
+		virtualBody.reserve(grid.Cells() + MAX_TAIL_SEGMENTS + 1);
+	}
+
+	eDirection Decide(const GameState& state) override
+	{
+		Clock::time_point start = Clock::now();
+		// The head moves continuously, so only turn once per cell and only after passing the cell
+		// centre; turning near a boundary lets it zig-zag straight back into its own neck
+		int headCell = grid.CellOf(state.head);
+		eDirection d = state.dir;
+		if (state.dir == eDirection::STOP || (headCell != plannedCell && grid.PastCellCenter(headCell, state.head, state.dir)))
+		{
+			d = Plan(state);
+			plannedCell = headCell;
+		}
+		double ms = MillisecondsSince(start);
+		searchMs += ms;
+		stats.Record(ms);
+		return d;
+	}
+
+	void Report(std::ostream& out) const override
+	{
+		out << "[Path] grid " << grid.width << "x" << grid.height
+			<< "  nodes expanded " << expanded
+			<< "  nodes/s " << (searchMs > 0.0 ? (double)expanded * 1000.0 / searchMs : 0.0)
+			<< "  fruit paths " << fruitPaths << " tail follows " << tailFollows << " fallbacks " << fallbacks << "\n";
+		out << "[Path] ";
+		stats.Report(out, "decisions");
+	}
+
+private:
+	// Head first, tail end last
+	void CollectBody(const GameState& state)
+	{
+		body.clear();
+		body.push_back(grid.CellOf(state.head));
+		for (uint32_t i = 0; i < state.tailCount; i++)
+		{
+			int cell = grid.CellOf(state.tails[i].position);
+			if (cell != body.back())
+				body.push_back(cell);
+		}
+	}
+
+	void MarkBlocked(const std::vector<int>& cells, bool freeTailEnd)
+	{
+		blocked.Clear();
+		size_t end = freeTailEnd && cells.size() > 1 ? cells.size() - 1 : cells.size();
+		for (size_t i = 1; i < end; i++)
+			blocked.Set(cells[i]);
+	}
+
+	void NextGeneration()
+	{
+		if (++generation == 0)
+		{
+			std::fill(stamp.begin(), stamp.end(), 0u);
+			generation = 1;
+		}
+	}
+
+	// BFS from start; stops when goal is dequeued (goal -1 floods everything). Returns cells reached.
+	int Search(int start, int goal)
+	{
+		NextGeneration();
+		int head = 0, tail = 0;
+		open[tail++] = start;
+		stamp[start] = generation;
+		parent[start] = -1;
+
+		while (head < tail)
+		{
+			int cell = open[head++];
+			expanded++;
+			if (cell == goal)
+				break;
+			for (int d = 0; d < DIRECTION_COUNT; d++)
+			{
+				int next = grid.Neighbor(cell, d);
+				if (next < 0 || stamp[next] == generation || (blocked.Test(next) && next != goal))
+					continue;
+				stamp[next] = generation;
+				parent[next] = cell;
+				open[tail++] = next;
+			}
+		}
+		return tail;
+	}
+
+	[[nodiscard]] bool Reached(int cell) const
+	{
+		return stamp[cell] == generation;
+	}
+
+	// Path start..goal (start excluded) from the parent links of the last search
+	void BuildPath(int goal)
+	{
+		path.clear();
+		for (int cell = goal; parent[cell] != -1; cell = parent[cell])
+			path.push_back(cell);
+		std::reverse(path.begin(), path.end());
+	}
+
+	// Would the head still reach the tail end after walking the current path to the fruit?
+	bool PathIsSafe()
+	{
+		virtualBody.clear();
+		for (auto it = path.rbegin(); it != path.rend(); ++it)
+			virtualBody.push_back(*it);
+		virtualBody.insert(virtualBody.end(), body.begin(), body.end());
+		// Eating grows the snake by one segment
+		virtualBody.resize(std::min(virtualBody.size(), body.size() + 1));
+
+		if (virtualBody.size() < 3)
+			return true;
+
+		MarkBlocked(virtualBody, true);
+		Search(virtualBody.front(), virtualBody.back());
+		return Reached(virtualBody.back());
+	}
+
+	eDirection Legal(const GameState& state, eDirection d) const
+	{
+		return d == OppositeDirection(state.dir) ? state.dir : d;
+	}
+
+	eDirection Plan(const GameState& state)
+	{
+		CollectBody(state);
+		int headCell = body.front();
+		int fruitCell = grid.CellOf(state.fruit);
+
+		// 1. Shortest path to the fruit, if it leaves a way back to the tail
+		MarkBlocked(body, false);
+		Search(headCell, fruitCell);
+		if (fruitCell != headCell && Reached(fruitCell))
+		{
+			BuildPath(fruitCell);
+			eDirection d = grid.DirectionTo(headCell, path.front());
+			if (d != OppositeDirection(state.dir) && PathIsSafe())
+			{
+				fruitPaths++;
+				return d;
+			}
+		}
+
+		// 2. Chase the tail end, which keeps moving away
+		if (body.size() > 2)
+		{
+			MarkBlocked(body, true);
+			Search(headCell, body.back());
+			if (Reached(body.back()))
+			{
+				BuildPath(body.back());
+				eDirection d = path.empty() ? eDirection::STOP : grid.DirectionTo(headCell, path.front());
+				if (d != eDirection::STOP && d != OppositeDirection(state.dir))
+				{
+					tailFollows++;
+					return d;
+				}
+			}
+		}
+
+		// 3. Step into the neighbour with the most reachable space
+		fallbacks++;
+		MarkBlocked(body, true);
+		eDirection best = Legal(state, state.dir == eDirection::STOP ? eDirection::UP : state.dir);
+		int bestArea = -1;
+		for (int d = 0; d < DIRECTION_COUNT; d++)
+		{
+			int next = grid.Neighbor(headCell, d);
+			if (next < 0 || blocked.Test(next) || GRID_DIRECTIONS[d] == OppositeDirection(state.dir))
+				continue;
+			blocked.Set(headCell);
+			int area = Search(next, -1);
+			if (area > bestArea)
+			{
+				bestArea = area;
+				best = GRID_DIRECTIONS[d];
+			}
+		}
+		return best;
+	}
+
+	BoardGrid grid;
+	CellBitset blocked;
+	std::vector<uint32_t> stamp;
+	std::vector<int> parent;
+	std::vector<int> open;
+	std::vector<int> path, body, virtualBody;
+	uint32_t generation = 0;
+	int plannedCell = -1;
+	uint64_t expanded = 0, fruitPaths = 0, tailFollows = 0, fallbacks = 0;
+	double searchMs = 0.0;
+};
@@ -0,0 +1,312 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "LatencyStats.h"
+#include "SpscQueue.h"
+
+// **********************************************************************************************
+//	Frame Profiler
+// **********************************************************************************************
+//	PROFILE_SCOPE("name") times the rest of the enclosing block. Each thread writes its events
+//	into its own lock-free ring (an SpscQueue it owns as the producer); the main thread drains
+//	every ring once per frame in EndFrame and adds each scope's time up per frame. GPU times
+//	from GpuTimerPool come in through RecordGpu.
+//
+//	Disabled at run time a scope costs one relaxed load and a branch. Building with
+//	SNAKE_NO_PROFILER removes the scopes altogether.
+//
+//	A thread hands its ring back when it exits, and the next new thread takes it over once the
+//	main thread has drained it, so short-lived threads such as std::async tasks do not use up
+//	the MAX_THREADS rings.
+//
+//	Scope names must be string literals or otherwise outlive the profiler; events keep the pointer.
+//	An event sink (src/ChromeTrace.h) can see every raw event as EndFrame drains it.
+
+struct ProfileEvent
+{
+	const char* name;
+	int64_t startNs;            // Since the profiler was created
+	int64_t endNs;
+};
+
+class Profiler
+{
+public:
+	static const int MAX_THREADS = 32;
+	static const int MAX_SCOPES = 32;
+	static const size_t RING_CAPACITY = 4096;
+
+	struct Scope
+	{
+		const char* name;
+		bool gpu;
+		double frameMs;         // Accumulating for the current frame
+		double lastMs;          // Total of the last finished frame
+		LatencyStats stats;     // Per-frame totals
+	};
+
+	// Main thread; thread is the index of the ring the event came from
+	using EventSink = std::function<void(int thread, const ProfileEvent& event)>;
+
+	static Profiler& Get()
+	{
+		static Profiler profiler;
+		return profiler;
+	}
+
+	// Main thread
+	void SetEnabled(bool on)
+	{
+		enabled.store(on, std::memory_order_relaxed);
+		enableCalls++;
+	}
+
+	// Main thread. Counts SetEnabled calls, so a caller can tell whether anyone else has set
+	// the state since it did, even to the same value.
+	[[nodiscard]] uint64_t EnableCalls() const
+	{
+		return enableCalls;
+	}
+
+	[[nodiscard]] bool Enabled() const
+	{
+		return enabled.load(std::memory_order_relaxed);
+	}
+
+	[[nodiscard]] int64_t Now() const
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count();
+	}
+
+	// Any thread. Never blocks; the first event of a thread registers its ring under a lock.
+	void Record(const char* name, int64_t startNs, int64_t endNs)
+	{
+		ThreadRing* ring = LocalRing();
+		if (ring == nullptr || !ring->events.Push({name, startNs, endNs}))
+			droppedEvents.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// Names the calling thread in traces; the name must outlive the profiler. Cheap: a thread
+	// only gets a ring when it records its first event.
+	void NameThread(const char* name)
+	{
+		LocalState& local = Local();
+		local.name = name;
+		if (local.ring != nullptr)
+			local.ring->name.store(name, std::memory_order_relaxed);
+	}
+
+	// Any thread; nullptr until the thread names itself
+	[[nodiscard]] const char* ThreadName(int thread) const
+	{
+		return thread < threadCount.load(std::memory_order_acquire) ? rings[thread]->name.load(std::memory_order_relaxed) : nullptr;
+	}
+
+	// Main thread. Pass nullptr to stop.
+	void SetEventSink(EventSink eventSink)
+	{
+		sink = std::move(eventSink);
+	}
+
+	// Main thread, between frames
+	void RecordGpu(const char* name, double ms)
+	{
+		Accumulate(name, true, ms);
+	}
+
+	// Writes one row per scope per frame from now on
+	bool OpenCsv(const std::string& path)
+	{
+		csv.open(path, std::ios::out | std::ios::trunc);
+		if (!csv)
+			return false;
+		csv << "frame,scope,source,ms\n";
+		return true;
+	}
+
+	// Main thread, once per frame: drains every ring and closes the frame's totals
+	void EndFrame()
+	{
+		if (!Enabled())
+			return;
+		ProfileEvent event;
+		int threads = threadCount.load(std::memory_order_acquire);
+		for (int i = 0; i < threads; i++)
+			while (rings[i]->events.Pop(event))
+			{
+				Accumulate(event.name, false, (double)(event.endNs - event.startNs) / 1e6);
+				if (sink)
+					sink(i, event);
+			}
+
+		for (int i = 0; i < scopeCount; i++)
+		{
+			Scope& scope = scopes[i];
+			scope.lastMs = scope.frameMs;
+			scope.stats.Record(scope.frameMs);
+			if (csv)
+				csv << frame << ',' << scope.name << ',' << (scope.gpu ? "gpu" : "cpu") << ',' << scope.frameMs << '\n';
+			scope.frameMs = 0.0;
+		}
+		frame++;
+	}
+
+	[[nodiscard]] const Scope* Scopes() const
+	{
+		return scopes;
+	}
+
+	[[nodiscard]] int ScopeCount() const
+	{
+		return scopeCount;
+	}
+
+	[[nodiscard]] uint64_t Frames() const
+	{
+		return frame;
+	}
+
+	[[nodiscard]] uint64_t DroppedEvents() const
+	{
+		return droppedEvents.load(std::memory_order_relaxed);
+	}
+
+	void Report(std::ostream& out) const
+	{
+		for (int i = 0; i < scopeCount; i++)
+		{
+			out << "[Profile] " << (scopes[i].gpu ? "gpu " : "cpu ");
+			scopes[i].stats.Report(out, scopes[i].name);
+		}
+		out << "[Profile] frames " << frame << "  dropped events " << DroppedEvents() << std::endl;
+	}
+
+private:
+	struct ThreadRing
+	{
+		SpscQueue<ProfileEvent, RING_CAPACITY> events;
+		std::atomic<const char*> name{nullptr};
+		std::atomic<bool> released{false};     // Its thread exited; the producer side is free
+	};
+
+	Profiler() : origin(std::chrono::steady_clock::now())
+	{
+	}
+
+	struct LocalState
+	{
+		ThreadRing* ring = nullptr;
+		bool registered = false;
+		const char* name = nullptr;
+
+		// Thread exit. Rings live as long as the profiler, so the pointer is still good.
+		~LocalState()
+		{
+			if (ring != nullptr)
+				ring->released.store(true, std::memory_order_release);
+		}
+	};
+
+	static LocalState& Local()
+	{
+		static thread_local LocalState local;
+		return local;
+	}
+
+	ThreadRing* LocalRing()
+	{
+		LocalState& local = Local();
+		if (!local.registered)
+		{
+			local.registered = true;
+			std::lock_guard<std::mutex> lock(registerMutex);
+			int count = threadCount.load(std::memory_order_relaxed);
+			// A ring still holding a dead thread's events would pass them off as this thread's
+			for (int i = 0; i < count && local.ring == nullptr; i++)
+				if (rings[i]->released.load(std::memory_order_acquire) && rings[i]->events.Size() == 0)
+				{
+					rings[i]->released.store(false, std::memory_order_relaxed);
+					rings[i]->name.store(local.name, std::memory_order_relaxed);
+					local.ring = rings[i].get();
+				}
+			if (local.ring == nullptr && count < MAX_THREADS)
+			{
+				rings[count].reset(new ThreadRing());
+				rings[count]->name.store(local.name, std::memory_order_relaxed);
+				local.ring = rings[count].get();
+				threadCount.store(count + 1, std::memory_order_release);
+			}
+		}
+		return local.ring;
+	}
+
+	// Main thread. Scopes are matched by name, so the same literal from two files is one scope.
+	void Accumulate(const char* name, bool gpu, double ms)
+	{
+		for (int i = 0; i < scopeCount; i++)
+			if (scopes[i].gpu == gpu && (scopes[i].name == name || std::strcmp(scopes[i].name, name) == 0))
+			{
+				scopes[i].frameMs += ms;
+				return;
+			}
+		if (scopeCount == MAX_SCOPES)
+			return;
+		Scope& scope = scopes[scopeCount++];
+		scope.name = name;
+		scope.gpu = gpu;
+		scope.frameMs = ms;
+		scope.lastMs = 0.0;
+	}
+
+	std::chrono::steady_clock::time_point origin;
+	std::atomic<bool> enabled{false};
+	uint64_t enableCalls = 0;           // Main thread
+	std::mutex registerMutex;
+	std::unique_ptr<ThreadRing> rings[MAX_THREADS];
+	std::atomic<int> threadCount{0};
+	std::atomic<uint64_t> droppedEvents{0};
+	Scope scopes[MAX_SCOPES] = {};      // Main thread
+	int scopeCount = 0;
+	uint64_t frame = 0;
+	std::ofstream csv;
+	EventSink sink;
+};
+
+// Times its own lifetime as one event
+class ProfileScope
+{
+public:
+	explicit ProfileScope(const char* name) : name(name), start(Profiler::Get().Enabled() ? Profiler::Get().Now() : -1)
+	{
+	}
+
+	~ProfileScope()
+	{
+		if (start >= 0)
+			Profiler::Get().Record(name, start, Profiler::Get().Now());
+	}
+
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+	const char* name;
+	int64_t start;
+};
+
+#if defined(SNAKE_NO_PROFILER)
+#define PROFILE_SCOPE(name)
+#else
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#endif
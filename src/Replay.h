@@ -0,0 +1,165 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "GameState.h"
+
+// **********************************************************************************************
+//	Replays
+// **********************************************************************************************
+//	A replay is the input of one session: the seed and clock the game started with, the length
+//	of every frame and what the player did in which frame. The game records one with
+//	--record and plays replays back in its benchmark mode (--replay); PlayReplayFrame plays
+//	the same input through a GameState. The same input on the same seed takes the game down
+//	the same path as long as every frame keeps its length.
+//
+//	A session starts at the game over screen, the way the game starts; REPLAY_RESTART is the
+//	RETURN key.
+//
+//	Layout, native little-endian:
+//		ReplayHeader
+//		uint16_t deltaMs[frames]
+//		ReplayEvent[events]        in frame order
+
+const uint32_t REPLAY_MAGIC = 0x4C505253;       // "SRPL"
+const uint32_t REPLAY_VERSION = 1;
+
+// The four directions share their eDirection values
+enum eReplayInput {REPLAY_LEFT = 1, REPLAY_RIGHT, REPLAY_UP, REPLAY_DOWN, REPLAY_RESTART, REPLAY_NEXT_DIFFICULTY, REPLAY_PAUSE};
+
+static_assert((int)REPLAY_LEFT == (int)eDirection::LEFT && (int)REPLAY_DOWN == (int)eDirection::DOWN,
+	"Replay directions are stored as eDirection values");
+
+struct ReplayHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t seed;
+	uint32_t startMs;           // Game clock before the first frame
+	uint32_t frames;
+	uint32_t events;
+	uint32_t reserved;
+};
+
+struct ReplayEvent
+{
+	uint32_t frame;
+	uint8_t input;              // eReplayInput
+	uint8_t reserved[3];
+};
+
+static_assert(sizeof(ReplayHeader) == 32, "ReplayHeader layout is part of the file format");
+static_assert(sizeof(ReplayEvent) == 8, "ReplayEvent layout is part of the file format");
+
+struct Replay
+{
+	uint64_t seed = 0;
+	uint32_t startMs = 0;
+	std::vector<uint16_t> deltaMs;
+	std::vector<ReplayEvent> events;
+
+	void Start(uint64_t startSeed, uint32_t clockMs)
+	{
+		seed = startSeed;
+		startMs = clockMs;
+		deltaMs.clear();
+		events.clear();
+	}
+
+	// Begins the next frame; inputs added after it belong to this frame
+	void AddFrame(uint32_t ms)
+	{
+		deltaMs.push_back((uint16_t)std::min<uint32_t>(ms, 0xFFFF));
+	}
+
+	void AddInput(eReplayInput input)
+	{
+		if (!deltaMs.empty())
+			events.push_back({(uint32_t)deltaMs.size() - 1, (uint8_t)input, {}});
+	}
+
+	[[nodiscard]] uint64_t DurationMs() const
+	{
+		uint64_t total = 0;
+		for (uint16_t ms : deltaMs)
+			total += ms;
+		return total;
+	}
+
+	bool Save(const std::string& path) const
+	{
+		ReplayHeader header = {REPLAY_MAGIC, REPLAY_VERSION, seed, startMs, (uint32_t)deltaMs.size(), (uint32_t)events.size(), 0};
+		FILE* file = std::fopen(path.c_str(), "wb");
+		if (file == nullptr)
+			return false;
+		bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1
+			&& std::fwrite(deltaMs.data(), sizeof(uint16_t), deltaMs.size(), file) == deltaMs.size()
+			&& std::fwrite(events.data(), sizeof(ReplayEvent), events.size(), file) == events.size();
+		return std::fclose(file) == 0 && ok;
+	}
+
+	// False for a missing, truncated or foreign file, or events out of frame order
+	bool Load(const std::string& path)
+	{
+		FILE* file = std::fopen(path.c_str(), "rb");
+		if (file == nullptr)
+			return false;
+		ReplayHeader header;
+		bool ok = std::fread(&header, sizeof(header), 1, file) == 1 && header.magic == REPLAY_MAGIC
+			&& header.version == REPLAY_VERSION;
+		if (ok)
+		{
+			deltaMs.resize(header.frames);
+			events.resize(header.events);
+			ok = std::fread(deltaMs.data(), sizeof(uint16_t), deltaMs.size(), file) == deltaMs.size()
+				&& std::fread(events.data(), sizeof(ReplayEvent), events.size(), file) == events.size();
+		}
+		std::fclose(file);
+		for (size_t i = 0; ok && i < events.size(); i++)
+			ok = events[i].frame < header.frames && (i == 0 || events[i].frame >= events[i - 1].frame);
+		if (!ok)
+			return false;
+		seed = header.seed;
+		startMs = header.startMs;
+		return true;
+	}
+};
+
+// **********************************************************************************************
+//	GameState playback
+// **********************************************************************************************
+
+// The state at the game over screen the game starts on
+inline void StartReplayState(GameState& s, const Replay& replay)
+{
+	InitGameState(s, replay.seed);
+	s.currentTime = replay.startMs;
+	EndGameState(s);
+}
+
+// Applies one input the way HandleInput does
+inline void ApplyReplayInput(GameState& s, eReplayInput input)
+{
+	if (input >= REPLAY_LEFT && input <= REPLAY_DOWN)
+		SteerGame(s, (eDirection)input);
+	else if (input == REPLAY_RESTART && s.gameOver)
+		RestartGameState(s);
+	else if (input == REPLAY_NEXT_DIFFICULTY && s.gameOver)
+		SetGameDifficulty(s, (eDifficulty)(((int)s.difficulty + 1) % 3));
+	else if (input == REPLAY_PAUSE)
+	{
+		s.dX = 0.0f; s.dY = 0.0f;
+		s.gameIsPaused = true;
+	}
+}
+
+// Plays frame number frame; next is the index of the first event not applied yet. Returns the
+// StepGame events.
+inline int PlayReplayFrame(GameState& s, const Replay& replay, uint32_t frame, size_t& next)
+{
+	while (next < replay.events.size() && replay.events[next].frame == frame)
+		ApplyReplayInput(s, (eReplayInput)replay.events[next++].input);
+	return StepGame(s, replay.deltaMs[frame]);
+}
@@ -0,0 +1,127 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <SDL2/SDL.h>
+
+// **********************************************************************************************
+//	Sample Pool
+// **********************************************************************************************
+//	All sound clips, converted to the obtained device format at load time and packed into one
+//	allocation. Every clip starts on an ALIGNMENT boundary so mixing kernels can use aligned
+//	loads. Clips are staged while loading and packed once; offsets are stable afterwards.
+
+class SamplePool
+{
+public:
+	static const size_t ALIGNMENT = 64;
+
+	struct Entry
+	{
+		std::string name;
+		size_t offset;              // In samples from the pool base, ALIGNMENT aligned
+		Uint32 frames;
+		Uint32 sourceBytes;         // Size of the decoded file data before conversion
+		SDL_AudioSpec sourceSpec;
+	};
+
+	// Converts data from sourceSpec to the device format and stages it. Returns the clip index or -1.
+	int Stage(const char* name, const Uint8* data, Uint32 length, const SDL_AudioSpec& sourceSpec, const SDL_AudioSpec& device)
+	{
+		SDL_AudioStream* stream = SDL_NewAudioStream(sourceSpec.format, sourceSpec.channels, sourceSpec.freq,
+			device.format, device.channels, device.freq);
+		if (stream == nullptr)
+			return -1;
+
+		std::vector<Sint16> samples;
+		if (SDL_AudioStreamPut(stream, data, (int)length) == 0 && SDL_AudioStreamFlush(stream) == 0)
+		{
+			samples.resize((size_t)SDL_AudioStreamAvailable(stream) / sizeof(Sint16));
+			int got = SDL_AudioStreamGet(stream, samples.data(), (int)(samples.size() * sizeof(Sint16)));
+			samples.resize(got > 0 ? (size_t)got / sizeof(Sint16) : 0);
+		}
+		SDL_FreeAudioStream(stream);
+		if (samples.empty())
+			return -1;
+
+		channels = device.channels;
+		entries.push_back({name, 0, (Uint32)(samples.size() / channels), length, sourceSpec});
+		staging.push_back(std::move(samples));
+		return (int)entries.size() - 1;
+	}
+
+	// Stages samples already in the device format, e.g. baked PCM; a plain copy
+	int StageConverted(const char* name, const Sint16* samples, Uint32 frames, int deviceChannels, Uint32 sourceBytes, const SDL_AudioSpec& sourceSpec)
+	{
+		if (frames == 0)
+			return -1;
+		channels = deviceChannels;
+		entries.push_back({name, 0, frames, sourceBytes, sourceSpec});
+		staging.emplace_back(samples, samples + (size_t)frames * channels);
+		return (int)entries.size() - 1;
+	}
+
+	// Packs every staged clip into a single aligned block and frees the staging buffers
+	void Pack()
+	{
+		const size_t alignSamples = ALIGNMENT / sizeof(Sint16);
+		size_t total = 0;
+		for (Entry& entry : entries)
+		{
+			entry.offset = total;
+			total += ((size_t)entry.frames * channels + alignSamples - 1) / alignSamples * alignSamples;
+		}
+
+		storage.assign(total * sizeof(Sint16) + ALIGNMENT, 0);
+		uintptr_t raw = reinterpret_cast<uintptr_t>(storage.data());
+		base = reinterpret_cast<Sint16*>((raw + ALIGNMENT - 1) & ~(uintptr_t)(ALIGNMENT - 1));
+
+		for (size_t i = 0; i < entries.size(); i++)
+		{
+			std::memcpy(base + entries[i].offset, staging[i].data(), staging[i].size() * sizeof(Sint16));
+			std::vector<Sint16>().swap(staging[i]);
+		}
+		staging.clear();
+	}
+
+	[[nodiscard]] const Sint16* Samples(int clip) const
+	{
+		return base + entries[clip].offset;
+	}
+
+	[[nodiscard]] Uint32 Frames(int clip) const
+	{
+		return entries[clip].frames;
+	}
+
+	[[nodiscard]] size_t Clips() const
+	{
+		return entries.size();
+	}
+
+	[[nodiscard]] size_t Bytes() const
+	{
+		return storage.size();
+	}
+
+	void Report(std::ostream& out) const
+	{
+		for (const Entry& entry : entries)
+		{
+			out << "[Audio] " << entry.name << ": source " << entry.sourceBytes << " bytes ("
+				<< entry.sourceSpec.freq << " Hz, " << (int)entry.sourceSpec.channels << " ch, "
+				<< SDL_AUDIO_BITSIZE(entry.sourceSpec.format) << " bit) -> pooled "
+				<< (size_t)entry.frames * channels * sizeof(Sint16) << " bytes at offset " << entry.offset << "\n";
+		}
+		out << "[Audio] sample pool " << Bytes() << " bytes for " << entries.size() << " clips\n";
+	}
+
+private:
+	std::vector<Entry> entries;
+	std::vector<std::vector<Sint16>> staging;
+	std::vector<Uint8> storage;
+	Sint16* base = nullptr;
+	int channels = 2;
+};
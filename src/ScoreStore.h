@@ -0,0 +1,356 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include "Core.h"
+#include "MappedFile.h"
+#include "SpscQueue.h"
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// **********************************************************************************************
+//	Score Store
+// **********************************************************************************************
+//	High scores and play statistics per difficulty, kept across runs in an append-only log.
+//
+//	Layout, native little-endian:
+//		ScoreLogHeader
+//		ScoreRecord[]          appended one per finished game
+//
+//	A record is the statistics of some number of games, so records simply add up: a finished
+//	game is a record with games = 1, and compaction folds the whole log into one record per
+//	difficulty. Each record carries a checksum. Reading stops at the first record that is short
+//	or fails its checksum, which is where a writer killed mid-append left off; the writer cuts
+//	that tail before it appends again. Compaction writes a new file and renames it over the
+//	log, so at any moment the file on disk is either the old log or the new one.
+//
+//	Open reads the log through a memory mapping. After that the game thread only touches the
+//	in-memory totals and a lock-free queue; appends, fsyncs and compaction run on the store's
+//	own writer thread.
+
+const uint32_t SCORE_LOG_MAGIC = 0x474F4C53;     // "SLOG"
+const uint32_t SCORE_LOG_VERSION = 1;
+const int SCORE_DIFFICULTIES = 3;
+
+struct ScoreLogHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t recordSize;
+	uint32_t checksum;          // FNV-1a 32 of the three fields above
+};
+
+struct ScoreRecord
+{
+	uint32_t checksum;          // FNV-1a 32 of the rest of the record
+	uint16_t difficulty;
+	uint16_t bestLevel;
+	uint32_t bestScore;
+	uint32_t games;
+	uint64_t totalScore;
+	uint64_t totalMs;           // Time played
+};
+
+static_assert(sizeof(ScoreLogHeader) == 16, "ScoreLogHeader layout is part of the file format");
+static_assert(sizeof(ScoreRecord) == 32, "ScoreRecord layout is part of the file format");
+
+inline uint32_t ChecksumScoreBytes(const uint8_t* data, size_t size)
+{
+	uint32_t hash = 0x811C9DC5u;
+	for (size_t i = 0; i < size; i++)
+		hash = (hash ^ data[i]) * 0x01000193u;
+	return hash;
+}
+
+inline uint32_t ChecksumScoreRecord(const ScoreRecord& record)
+{
+	return ChecksumScoreBytes(reinterpret_cast<const uint8_t*>(&record) + sizeof(uint32_t), sizeof(ScoreRecord) - sizeof(uint32_t));
+}
+
+inline ScoreLogHeader MakeScoreLogHeader()
+{
+	ScoreLogHeader header = {SCORE_LOG_MAGIC, SCORE_LOG_VERSION, (uint32_t)sizeof(ScoreRecord), 0};
+	header.checksum = ChecksumScoreBytes(reinterpret_cast<const uint8_t*>(&header), offsetof(ScoreLogHeader, checksum));
+	return header;
+}
+
+// Adds the games of one record to another
+inline void FoldScoreRecord(ScoreRecord& into, const ScoreRecord& record)
+{
+	into.bestLevel = std::max(into.bestLevel, record.bestLevel);
+	into.bestScore = std::max(into.bestScore, record.bestScore);
+	into.games += record.games;
+	into.totalScore += record.totalScore;
+	into.totalMs += record.totalMs;
+}
+
+class ScoreStore
+{
+public:
+	static const uint32_t COMPACT_AFTER_RECORDS = 256;
+
+	ScoreStore()
+	{
+		for (int d = 0; d < SCORE_DIFFICULTIES; d++)
+		{
+			totals[d] = ScoreRecord();
+			totals[d].difficulty = (uint16_t)d;
+		}
+	}
+
+	ScoreStore(const ScoreStore&) = delete;
+	ScoreStore& operator=(const ScoreStore&) = delete;
+
+	~ScoreStore()
+	{
+		Close();
+	}
+
+	// Loads the log and starts the writer. A missing log is a fresh start; an unreadable one is
+	// left untouched and the store runs in memory only.
+	bool Open(const std::string& logPath)
+	{
+		Close();
+		path = logPath;
+		validRecords = 0;
+		if (!Load())
+		{
+			std::cout << "Score log " << path << " is not readable, scores will not be saved" << std::endl;
+			return false;
+		}
+		for (int d = 0; d < SCORE_DIFFICULTIES; d++)
+			written[d] = totals[d];
+		stopping.store(false, std::memory_order_relaxed);
+		writer = std::thread(&ScoreStore::Run, this);
+		return true;
+	}
+
+	// Writes out everything queued and stops the writer
+	void Close()
+	{
+		if (!writer.joinable())
+			return;
+		stopping.store(true, std::memory_order_release);
+		wake.notify_one();
+		writer.join();
+	}
+
+	// Game thread. O(1), never blocks; the record reaches the disk on the writer thread.
+	void RecordGame(eDifficulty difficulty, uint32_t score, uint32_t level, uint32_t durationMs)
+	{
+		int d = std::clamp((int)difficulty, 0, SCORE_DIFFICULTIES - 1);
+		ScoreRecord record = {0, (uint16_t)d, (uint16_t)std::min(level, 0xFFFFu), score, 1, score, durationMs};
+		record.checksum = ChecksumScoreRecord(record);
+		FoldScoreRecord(totals[d], record);
+		if (!writer.joinable())
+			return;
+		if (!records.Push(record))
+			droppedRecords.fetch_add(1, std::memory_order_relaxed);
+		wake.notify_one();
+	}
+
+	[[nodiscard]] uint32_t BestScore(eDifficulty difficulty) const
+	{
+		return totals[std::clamp((int)difficulty, 0, SCORE_DIFFICULTIES - 1)].bestScore;
+	}
+
+	[[nodiscard]] const ScoreRecord& Totals(eDifficulty difficulty) const
+	{
+		return totals[std::clamp((int)difficulty, 0, SCORE_DIFFICULTIES - 1)];
+	}
+
+	[[nodiscard]] uint64_t DroppedRecords() const
+	{
+		return droppedRecords.load(std::memory_order_relaxed);
+	}
+
+	void Report(std::ostream& out) const
+	{
+		const char* names[SCORE_DIFFICULTIES] = {"easy", "medium", "hard"};
+		for (int d = 0; d < SCORE_DIFFICULTIES; d++)
+		{
+			const ScoreRecord& t = totals[d];
+			out << "[Stats] " << names[d] << ": games " << t.games << "  best score " << t.bestScore
+				<< "  best level " << t.bestLevel << "  mean score " << (t.games ? (double)t.totalScore / t.games : 0.0)
+				<< "  minutes played " << (double)t.totalMs / 60000.0 << "\n";
+		}
+		out << "[Stats] log " << path << "  dropped records " << DroppedRecords() << std::endl;
+	}
+
+private:
+	// Game thread, before the writer starts
+	bool Load()
+	{
+		std::error_code error;
+		if (!std::filesystem::exists(path, error))
+			return !error;
+
+		MappedFile file;
+		if (!file.Open(path.c_str()))
+			return std::filesystem::file_size(path, error) == 0 && !error;
+		ScoreLogHeader expected = MakeScoreLogHeader();
+		if (file.Size() < sizeof(ScoreLogHeader) || std::memcmp(file.Data(), &expected, sizeof(expected)) != 0)
+			return false;
+
+		const uint8_t* data = file.Data() + sizeof(ScoreLogHeader);
+		size_t count = (file.Size() - sizeof(ScoreLogHeader)) / sizeof(ScoreRecord);
+		for (size_t i = 0; i < count; i++)
+		{
+			ScoreRecord record;
+			std::memcpy(&record, data + i * sizeof(ScoreRecord), sizeof(record));
+			if (record.checksum != ChecksumScoreRecord(record) || record.difficulty >= SCORE_DIFFICULTIES)
+				break;
+			FoldScoreRecord(totals[record.difficulty], record);
+			validRecords++;
+		}
+		return true;
+	}
+
+	void Run()
+	{
+		FILE* log = OpenForAppend();
+		ScoreRecord record;
+		while (true)
+		{
+			{
+				// Notify does not take the lock, so a wakeup can be missed; the timeout bounds the delay
+				std::unique_lock<std::mutex> lock(wakeMutex);
+				wake.wait_for(lock, std::chrono::milliseconds(250),
+					[&] { return records.Size() > 0 || stopping.load(std::memory_order_acquire); });
+			}
+			bool stop = stopping.load(std::memory_order_acquire);
+
+			bool appended = false;
+			while (records.Pop(record))
+			{
+				FoldScoreRecord(written[record.difficulty], record);
+				if (log != nullptr && std::fwrite(&record, sizeof(record), 1, log) == 1)
+				{
+					validRecords++;
+					appended = true;
+				}
+			}
+			if (appended && !Sync(log))
+			{
+				std::cout << "Failed to write score log " << path << std::endl;
+				std::fclose(log);
+				log = nullptr;
+			}
+			if (log != nullptr && validRecords >= COMPACT_AFTER_RECORDS)
+			{
+				std::fclose(log);
+				Compact();
+				log = OpenForAppend();
+			}
+			if (stop)
+				break;
+		}
+		if (log != nullptr)
+			std::fclose(log);
+	}
+
+	// Creates the log, or cuts a torn record off its end, and opens it for appending
+	FILE* OpenForAppend()
+	{
+		std::error_code error;
+		uint64_t size = sizeof(ScoreLogHeader) + (uint64_t)validRecords * sizeof(ScoreRecord);
+		if (!std::filesystem::exists(path, error) || std::filesystem::file_size(path, error) < sizeof(ScoreLogHeader))
+		{
+			if (!WriteLog(nullptr, 0))
+				return nullptr;
+		}
+		else if (std::filesystem::file_size(path, error) != size)
+			std::filesystem::resize_file(path, size, error);
+		if (error)
+			return nullptr;
+		return std::fopen(path.c_str(), "ab");
+	}
+
+	// Rewrites the log as one record per difficulty
+	void Compact()
+	{
+		ScoreRecord folded[SCORE_DIFFICULTIES];
+		uint32_t count = 0;
+		for (int d = 0; d < SCORE_DIFFICULTIES; d++)
+			if (written[d].games > 0)
+			{
+				folded[count] = written[d];
+				folded[count].checksum = ChecksumScoreRecord(folded[count]);
+				count++;
+			}
+		if (WriteLog(folded, count))
+			validRecords = count;
+	}
+
+	// Writes header and records beside the log, syncs, then renames over it
+	bool WriteLog(const ScoreRecord* recordsToWrite, uint32_t count)
+	{
+		std::string temporary = path + ".tmp";
+		ScoreLogHeader header = MakeScoreLogHeader();
+		FILE* file = std::fopen(temporary.c_str(), "wb");
+		bool ok = file != nullptr && std::fwrite(&header, sizeof(header), 1, file) == 1
+			&& (count == 0 || std::fwrite(recordsToWrite, sizeof(ScoreRecord), count, file) == count) && Sync(file);
+		ok = file != nullptr && std::fclose(file) == 0 && ok;
+
+		std::error_code error;
+		if (ok)
+			std::filesystem::rename(temporary, path, error);
+		if (!ok || error)
+		{
+			std::remove(temporary.c_str());
+			return false;
+		}
+		SyncDirectory();
+		return true;
+	}
+
+	static bool Sync(FILE* file)
+	{
+		if (std::fflush(file) != 0)
+			return false;
+#if defined(_WIN32)
+		return _commit(_fileno(file)) == 0;
+#else
+		return fsync(fileno(file)) == 0;
+#endif
+	}
+
+	// Makes a rename durable; Windows commits it with the file
+	void SyncDirectory() const
+	{
+#if !defined(_WIN32)
+		std::string directory = std::filesystem::path(path).parent_path().string();
+		int descriptor = open(directory.empty() ? "." : directory.c_str(), O_RDONLY);
+		if (descriptor >= 0)
+		{
+			fsync(descriptor);
+			close(descriptor);
+		}
+#endif
+	}
+
+	std::string path;
+	ScoreRecord totals[SCORE_DIFFICULTIES];     // Game thread
+	ScoreRecord written[SCORE_DIFFICULTIES];    // Writer thread once started
+	uint32_t validRecords = 0;                  // Writer thread once started
+	SpscQueue<ScoreRecord, 64> records;
+	std::atomic<uint64_t> droppedRecords{0};
+	std::atomic<bool> stopping{false};
+	std::mutex wakeMutex;
+	std::condition_variable wake;
+	std::thread writer;
+};
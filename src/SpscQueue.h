@@ -0,0 +1,49 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+
+// **********************************************************************************************
+//	Single-Producer Single-Consumer Queue
+// **********************************************************************************************
+//	Fixed-capacity lock-free ring. One thread may Push and one other thread may Pop; neither
+//	ever blocks or allocates. Capacity must be a power of two.
+
+template <typename T, size_t CAPACITY>
+class SpscQueue
+{
+	static_assert((CAPACITY & (CAPACITY - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+public:
+	// Returns false when the queue is full
+	bool Push(const T& item)
+	{
+		size_t tail = writeIndex.load(std::memory_order_relaxed);
+		if (tail - readIndex.load(std::memory_order_acquire) == CAPACITY)
+			return false;
+		items[tail & (CAPACITY - 1)] = item;
+		writeIndex.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Returns false when the queue is empty
+	bool Pop(T& item)
+	{
+		size_t head = readIndex.load(std::memory_order_relaxed);
+		if (head == writeIndex.load(std::memory_order_acquire))
+			return false;
+		item = items[head & (CAPACITY - 1)];
+		readIndex.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	[[nodiscard]] size_t Size() const
+	{
+		return writeIndex.load(std::memory_order_acquire) - readIndex.load(std::memory_order_acquire);
+	}
+
+private:
+	T items[CAPACITY];
+	// Separate cache lines so producer and consumer do not false-share
+	alignas(64) std::atomic<size_t> writeIndex{0};
+	alignas(64) std::atomic<size_t> readIndex{0};
+};
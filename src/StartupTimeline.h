@@ -0,0 +1,172 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+
+// **********************************************************************************************
+//	Startup Timeline
+// **********************************************************************************************
+//	Records when each startup phase began and ended, on whichever thread ran it, relative to
+//	program start. The KPI is time to first frame: the end of the first buffer swap.
+//	Phases are kept in a fixed array, so recording never allocates.
+
+class StartupTimeline
+{
+public:
+	using Clock = std::chrono::steady_clock;
+	static const int MAX_PHASES = 32;
+
+	StartupTimeline() : origin(Clock::now())
+	{
+	}
+
+	// Returns a handle for End, or -1 when the table is full
+	int Begin(const char* name)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (count == MAX_PHASES)
+			return -1;
+		phases[count] = {name, Now(), -1.0, ThreadIndex()};
+		return count++;
+	}
+
+	void End(int phase)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (phase >= 0 && phase < count)
+			phases[phase].endMs = Now();
+	}
+
+	// A zero-length phase
+	void Mark(const char* name)
+	{
+		End(Begin(name));
+	}
+
+	// Milliseconds since the timeline was created
+	[[nodiscard]] double Now() const
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - origin).count();
+	}
+
+	// End of the named phase in milliseconds, or -1 if it has not finished
+	[[nodiscard]] double EndOf(const char* name) const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (int i = 0; i < count; i++)
+			if (std::string(phases[i].name) == name)
+				return phases[i].endMs;
+		return -1.0;
+	}
+
+	void Report(std::ostream& out) const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		Phase sorted[MAX_PHASES];
+		std::copy(phases, phases + count, sorted);
+		std::stable_sort(sorted, sorted + count, [](const Phase& a, const Phase& b) { return a.startMs < b.startMs; });
+
+		out << "[Startup] " << std::left << std::setw(24) << "phase" << "thread  start ms    end ms  duration\n";
+		for (int i = 0; i < count; i++)
+		{
+			const Phase& p = sorted[i];
+			out << "[Startup] " << std::left << std::setw(24) << p.name << std::right << std::setw(6) << p.thread
+				<< std::fixed << std::setprecision(2) << std::setw(10) << p.startMs;
+			if (p.endMs < 0.0)
+				out << "   running\n";
+			else
+				out << std::setw(10) << p.endMs << std::setw(10) << p.endMs - p.startMs << "\n";
+		}
+		out << std::defaultfloat;
+	}
+
+private:
+	struct Phase
+	{
+		const char* name;
+		double startMs;
+		double endMs;
+		int thread;     // 0 is the thread that created the timeline
+	};
+
+	int ThreadIndex()
+	{
+		std::thread::id id = std::this_thread::get_id();
+		for (int i = 0; i < threadCount; i++)
+			if (threads[i] == id)
+				return i;
+		if (threadCount < MAX_PHASES)
+			threads[threadCount++] = id;
+		return threadCount - 1;
+	}
+
+	Clock::time_point origin;
+	mutable std::mutex mutex;
+	Phase phases[MAX_PHASES];
+	int count = 0;
+	std::thread::id threads[MAX_PHASES] = {std::this_thread::get_id()};
+	int threadCount = 1;
+};
+
+// Times a scope as one phase
+class TimelinePhase
+{
+public:
+	TimelinePhase(StartupTimeline& timeline, const char* name) : timeline(timeline), phase(timeline.Begin(name))
+	{
+	}
+
+	~TimelinePhase()
+	{
+		timeline.End(phase);
+	}
+
+	TimelinePhase(const TimelinePhase&) = delete;
+	TimelinePhase& operator=(const TimelinePhase&) = delete;
+
+private:
+	StartupTimeline& timeline;
+	int phase;
+};
+
+// A job started on its own thread at startup. The game polls Ready() before first use of what
+// the job produces; until then the job owns that data and the game must not touch it.
+class AsyncTask
+{
+public:
+	void Start(std::function<void()> job)
+	{
+		done = false;
+		future = std::async(std::launch::async, std::move(job));
+	}
+
+	// Never blocks. Rethrows anything the job threw, once.
+	bool Ready()
+	{
+		if (!done && future.valid() && future.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+			Finish();
+		return done;
+	}
+
+	void Wait()
+	{
+		if (!done && future.valid())
+			Finish();
+	}
+
+private:
+	void Finish()
+	{
+		done = true;
+		future.get();
+	}
+
+	std::future<void> future;
+	bool done = false;
+};
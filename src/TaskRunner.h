@@ -0,0 +1,240 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Profiler.h"
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// **********************************************************************************************
+//	Work-stealing Task Runner
+// **********************************************************************************************
+//	Splits an index range [0, count) across worker threads. Every worker owns a deque of ranges:
+//	it takes work from the back of its own deque and, when that runs dry, steals from the front
+//	of another worker's deque. Large ranges are halved before running so there is always
+//	something left to steal.
+//
+//	Results are deterministic regardless of thread count as long as a job only writes to the
+//	slot of its own index and derives any randomness from TaskSeed(seed, index).
+
+class TaskRunner
+{
+public:
+	explicit TaskRunner(unsigned int threadCount = 0, bool pinThreads = false)
+	{
+		if (threadCount == 0)
+			threadCount = std::thread::hardware_concurrency();
+		if (threadCount == 0)
+			threadCount = 1;
+
+		for (unsigned int i = 0; i < threadCount; i++)
+			workers.emplace_back(new Worker());
+
+		for (unsigned int i = 0; i < threadCount; i++)
+			workers[i]->thread = std::thread(&TaskRunner::WorkerLoop, this, i, pinThreads);
+	}
+
+	TaskRunner(const TaskRunner&) = delete;
+	TaskRunner& operator=(const TaskRunner&) = delete;
+
+	~TaskRunner()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		wake.notify_all();
+		for (auto& worker : workers)
+			worker->thread.join();
+	}
+
+	[[nodiscard]] unsigned int ThreadCount() const
+	{
+		return (unsigned int)workers.size();
+	}
+
+	// Calls job(index) for every index in [0, count) and blocks until all of them are done.
+	// Ranges no larger than grain are never split further.
+	void ParallelFor(size_t count, const std::function<void(size_t)>& job, size_t grain = 1)
+	{
+		if (count == 0)
+			return;
+
+		std::unique_lock<std::mutex> lock(mutex);
+		currentJob = &job;
+		this->grain = grain == 0 ? 1 : grain;
+		remaining.store(count, std::memory_order_relaxed);
+
+		// Contiguous partition, one slice per worker
+		size_t n = workers.size();
+		for (size_t i = 0; i < n; i++)
+		{
+			size_t begin = count * i / n;
+			size_t end = count * (i + 1) / n;
+			if (begin == end)
+				continue;
+			std::lock_guard<std::mutex> dequeLock(workers[i]->lock);
+			workers[i]->ranges.push_back({begin, end});
+		}
+
+		generation++;
+		wake.notify_all();
+		done.wait(lock, [this]{ return remaining.load(std::memory_order_acquire) == 0 && busy == 0; });
+		currentJob = nullptr;
+	}
+
+	// Per-task seed that only depends on the batch seed and the task index (SplitMix64)
+	static uint64_t TaskSeed(uint64_t seed, uint64_t index)
+	{
+		uint64_t z = seed + (index + 1) * 0x9E3779B97F4A7C15ull;
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		return z ^ (z >> 31);
+	}
+
+	// Number of ranges taken from another worker's deque since construction
+	[[nodiscard]] uint64_t StealCount() const
+	{
+		return steals.load(std::memory_order_relaxed);
+	}
+
+private:
+	struct Range
+	{
+		size_t begin, end;
+	};
+
+	struct Worker
+	{
+		std::mutex lock;
+		std::deque<Range> ranges;
+		std::thread thread;
+	};
+
+	static void PinCurrentThread(unsigned int index)
+	{
+		unsigned int cpus = std::thread::hardware_concurrency();
+		if (cpus == 0)
+			return;
+		unsigned int cpu = index % cpus;
+#if defined(_WIN32)
+		if (cpu < sizeof(DWORD_PTR) * 8)
+			SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << cpu);
+#elif defined(__linux__)
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(cpu, &set);
+		pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#endif
+	}
+
+	bool PopOwn(unsigned int index, Range& out)
+	{
+		Worker& self = *workers[index];
+		std::lock_guard<std::mutex> lock(self.lock);
+		if (self.ranges.empty())
+			return false;
+		out = self.ranges.back();
+		self.ranges.pop_back();
+		return true;
+	}
+
+	bool Steal(unsigned int index, Range& out)
+	{
+		size_t n = workers.size();
+		for (size_t k = 1; k < n; k++)
+		{
+			Worker& victim = *workers[(index + k) % n];
+			std::lock_guard<std::mutex> lock(victim.lock);
+			if (victim.ranges.empty())
+				continue;
+			out = victim.ranges.front();
+			victim.ranges.pop_front();
+			steals.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+		return false;
+	}
+
+	void Execute(unsigned int index, Range range)
+	{
+		// Keep halving, leaving the upper half for thieves
+		while (range.end - range.begin > grain)
+		{
+			size_t middle = range.begin + (range.end - range.begin) / 2;
+			{
+				std::lock_guard<std::mutex> lock(workers[index]->lock);
+				workers[index]->ranges.push_back({middle, range.end});
+			}
+			range.end = middle;
+		}
+
+		const std::function<void(size_t)>& job = *currentJob;
+		for (size_t i = range.begin; i < range.end; i++)
+			job(i);
+
+		remaining.fetch_sub(range.end - range.begin, std::memory_order_acq_rel);
+	}
+
+	void Drain(unsigned int index)
+	{
+		Range range{};
+		while (remaining.load(std::memory_order_acquire) != 0)
+		{
+			if (PopOwn(index, range) || Steal(index, range))
+				Execute(index, range);
+			else
+				std::this_thread::yield();
+		}
+	}
+
+	void WorkerLoop(unsigned int index, bool pin)
+	{
+		if (pin)
+			PinCurrentThread(index);
+		Profiler::Get().NameThread("task worker");
+
+		uint64_t seen = 0;
+		for (;;)
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [&]{ return stopping || generation != seen; });
+			if (stopping)
+				return;
+			seen = generation;
+			busy++;
+			lock.unlock();
+
+			Drain(index);
+
+			lock.lock();
+			if (--busy == 0 && remaining.load(std::memory_order_acquire) == 0)
+				done.notify_all();
+		}
+	}
+
+	std::vector<std::unique_ptr<Worker>> workers;
+	std::mutex mutex;
+	std::condition_variable wake, done;
+	const std::function<void(size_t)>* currentJob = nullptr;
+	size_t grain = 1;
+	uint64_t generation = 0;
+	unsigned int busy = 0;
+	bool stopping = false;
+	std::atomic<size_t> remaining{0};
+	std::atomic<uint64_t> steals{0};
+};
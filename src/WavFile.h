@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <SDL2/SDL.h>
+
+// **********************************************************************************************
+//	WAV Parsing
+// **********************************************************************************************
+//	Finds the format and PCM data of a RIFF/WAVE image already in memory, without copying.
+//	Handles integer PCM (8/16/32 bit) and 32-bit float, which covers everything in assets/.
+
+struct WavInfo
+{
+	SDL_AudioSpec spec;
+	const uint8_t* pcm;
+	uint32_t bytes;
+};
+
+inline uint32_t ReadLE32(const uint8_t* p)
+{
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+inline uint16_t ReadLE16(const uint8_t* p)
+{
+	return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+inline bool ParseWav(const uint8_t* data, size_t size, WavInfo& info)
+{
+	if (size < 12 || std::memcmp(data, "RIFF", 4) != 0 || std::memcmp(data + 8, "WAVE", 4) != 0)
+		return false;
+
+	bool haveFormat = false;
+	std::memset(&info, 0, sizeof(info));
+	size_t offset = 12;
+	while (offset + 8 <= size)
+	{
+		const uint8_t* chunk = data + offset;
+		uint32_t length = ReadLE32(chunk + 4);
+		const uint8_t* body = chunk + 8;
+		size_t available = size - offset - 8;
+
+		if (std::memcmp(chunk, "fmt ", 4) == 0 && length >= 16 && available >= 16)
+		{
+			uint16_t encoding = ReadLE16(body);
+			uint16_t bits = ReadLE16(body + 14);
+			info.spec.channels = (Uint8)ReadLE16(body + 2);
+			info.spec.freq = (int)ReadLE32(body + 4);
+			if (encoding == 3 && bits == 32)
+				info.spec.format = AUDIO_F32LSB;
+			else if (encoding == 1 && bits == 8)
+				info.spec.format = AUDIO_U8;
+			else if (encoding == 1 && bits == 16)
+				info.spec.format = AUDIO_S16LSB;
+			else if (encoding == 1 && bits == 32)
+				info.spec.format = AUDIO_S32LSB;
+			else
+				return false;
+			haveFormat = true;
+		}
+		else if (std::memcmp(chunk, "data", 4) == 0)
+		{
+			info.pcm = body;
+			info.bytes = (uint32_t)(length < available ? length : available);
+			return haveFormat && info.spec.channels > 0;
+		}
+		offset += 8 + length + (length & 1);
+	}
+	return false;
+}
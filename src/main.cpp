@@ -1,12 +1,44 @@
 #define GLEW_STATIC
 #include "GLEW/glew.h"
 #include <iostream>
+#include <memory>
+#include <string>
 #include <vector>
+#include <set>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
 #include <cmath>
 #include <ctime>
-#include <random>
+#include <chrono>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <limits>
+#include <type_traits>
 #include <SDL2/SDL.h>
 #include "SDL2/SDL_audio.h"
+#include "Core.h"
+#include "GameState.h"
+#include "MctsAutopilot.h"
+#include "PathAutopilot.h"
+#include "HamiltonAutopilot.h"
+#include "AudioMixer.h"
+#include "SamplePool.h"
+#include "MusicStream.h"
+#include "ChipSynth.h"
+#include "AssetArchive.h"
+#include "BakedAssets.h"
+#include "StartupTimeline.h"
+#include "AssetWatcher.h"
+#include "ScoreStore.h"
+#include "Profiler.h"
+#include "GpuTimer.h"
+#include "ChromeTrace.h"
+#include "AllocTracker.h"
+#include "Metrics.h"
+#include "Replay.h"
+#include "WavFile.h"
 // #include "SDL_ttf.h"
 
 // **********************************************************************************************
@@ -18,26 +50,15 @@ const int SUCCESS = 0, FAILED = -1;
 SDL_Window* myWindow = nullptr;
 SDL_GLContext myContext = nullptr;
 
-enum eDirection {STOP = 0, LEFT, RIGHT, UP, DOWN};
-enum eDifficulty {EASY = 0, MEDIUM, HARD [[maybe_unused]]
-};
-
 // **********************************************************************************************
 //	Shader Setups
 // **********************************************************************************************
-const char* vertexSource = 
-	"#version 330 core\n"
-	"layout(location = 0) in vec2 position;\n"
-	"void main(){\n"
-	"	gl_Position = vec4(position.xy, 0.0f, 1.0f);\n"
-	"}\n";
-
-const char* fragmentSource =
-	"#version 330 core\n"
-	"out vec4 color;\n"
-	"void main(){\n"
-	"	color = vec4(0.1f, 0.5f, 0.1f, 1.0f);\n"
-	"}\n";
+const char* VERTEX_SHADER_ASSET = "shader/snake.vert";
+const char* FRAGMENT_SHADER_ASSET = "shader/snake.frag";
+const char* OVERLAY_VERTEX_SHADER_ASSET = "shader/overlay.vert";
+const char* OVERLAY_FRAGMENT_SHADER_ASSET = "shader/overlay.frag";
+const char* FONT_ASSET = "font/Pixeboy-z8XGD/Pixeboy-z8XGD.ttf";
+const char* EFFECT_ASSETS[] = {"audio/carrotnom-92106.wav", "audio/mixkit-retro-game-over-1947.wav"};
 
 static unsigned int compileShader(unsigned int type, const std::string& source)
 {
@@ -64,12 +85,19 @@ static unsigned int compileShader(unsigned int type, const std::string& source)
 	return id;
 }
 
+// Returns 0 if either shader fails to compile or the program fails to link
 static unsigned int SetUpShaders(const std::string& vertex, const std::string& fragment)
 {
-	unsigned int program = glCreateProgram();
 	unsigned int vs = compileShader(GL_VERTEX_SHADER, vertex);
 	unsigned int fs = compileShader(GL_FRAGMENT_SHADER, fragment);
+	if (vs == 0 || fs == 0)
+	{
+		glDeleteShader(vs);
+		glDeleteShader(fs);
+		return 0;
+	}
 
+	unsigned int program = glCreateProgram();
 	glAttachShader(program, vs);
 	glAttachShader(program, fs);
 	glLinkProgram(program);
@@ -78,6 +106,18 @@ static unsigned int SetUpShaders(const std::string& vertex, const std::string& f
 	glDeleteShader(vs);
 	glDeleteShader(fs);
 
+	int result;
+	glGetProgramiv(program, GL_LINK_STATUS, &result);
+	if (result == GL_FALSE)
+	{
+		char message[1024];
+		glGetProgramInfoLog(program, sizeof(message), nullptr, message);
+		std::cout << "Failed to Link shader program!" << std::endl;
+		std::cout << message << std::endl;
+		glDeleteProgram(program);
+		return 0;
+	}
+
 	return program;
 }
 
@@ -85,111 +125,58 @@ static unsigned int SetUpShaders(const std::string& vertex, const std::string& f
 //	Structs and namespace Declarations & Definitions
 // **********************************************************************************************
 
-struct Vector
-{
-    Vector() 
-	{
-		x = 0.0f;
-		y = 0.0f;
-	}
-    
-	Vector(float _x, float _y) 
-	{
-		x = _x;
-		y = _y;
-	}
-    
-	Vector(const Vector& v) 
-	{
-		x = v.x;
-		y = v.y;
-	}
-    
-	~Vector()= default;
-
-	static float Distance(const Vector& _this, const Vector& other)
-	{
-		float x = (other.x - _this.x);
-		float y = (other.y - _this.y);
-		float d = std::sqrt((x*x) + (y*y));
-		return d;
-	} 
-
-    Vector operator+(const Vector& other) const 
-	{
-        return {x + other.x, y + other.y};
-    }
-
-    Vector operator-(const Vector& other) const 
-	{
-        return {x - other.x, y - other.y};
-    }
-
-    Vector operator*(float s) const 
-	{
-        return {x * s, y * s};
-    }
-
-    Vector operator/(float s) const 
-	{
-        if (s != 0) {
-            return {x / s, y / s};
-        } else {
-            return *this;
-        }
-    }
-    
-	Vector& operator+=(const Vector& other) 
-	{
-        x += other.x;
-        y += other.y;
-        return *this;
-    }
-
-    Vector& operator-=(const Vector& other) 
-	{
-        x -= other.x;
-        y -= other.y;
-        return *this;
-    }
-
-    Vector& operator*=(float s) 
-	{
-        x *= s;
-        y *= s;
-        return *this;
-    }
-
-    Vector& operator/=(float s) 
-	{
-        if (s != 0) {
-            x /= s;
-            y /= s;
-        }
-        return *this;
-    }
-
-    float x, y;
-};
-
-Vector operator*(float s, const Vector& v) 
-{
-    return {v.x * s, v.y * s};
-}
-
 struct AudioSource{
-    Uint8* data;        // Pointer to audio data
-    Uint32 length;      // Length of the audio data in bytes
-//    Uint32 position;    // Current position in the audio data
-    SDL_AudioSpec spec; // Audio specification for this source
+    const Sint16* data; // First sample inside Global::samplePool, in the device format
+    Uint32 frames;      // Length of the audio data in frames
+    int clip;           // Clip id in the mixer
 };
 
 namespace Global
 {
 	unsigned int shader = 0, VBO = 0, VAO = 0;
 	std::vector<AudioSource> audioSources;
-//	SDL_AudioSpec audioSpec;
+	SDL_AudioSpec audioSpec;
 	SDL_AudioDeviceID audioDevice;
+	AudioMixer mixer;
+	SamplePool samplePool;
+	MusicStream music;
+	std::string musicPath;
+	ChipSynth synth;
+	bool synthAudio = false;
+	AssetArchive assets;
+	std::string basePath;
+	FontAtlasView font{};
+	bool fontLoaded = false;
+	StartupTimeline timeline;
+	AsyncTask audioTask;    // Owns the audio globals until Ready()
+	AsyncTask fontTask;     // Owns font and fontLoaded until Ready()
+	bool startupReport = false;
+	bool audioEnabled = true;
+	bool hotReload = false;
+	AssetWatcher watcher;
+	std::set<std::string> editedAssets;    // Loose files saved while running, they win over assets.pak
+	SamplePool reloadPool;
+	AsyncTask audioReloadTask;              // Owns reloadPool until Ready()
+	bool audioReloading = false;
+	ScoreStore scores;
+	bool statsReport = false;
+	GpuTimerPool gpuTimers;
+	bool profilerOverlay = false;
+	unsigned int overlayShader = 0, overlayVAO = 0, overlayVBO = 0, overlayAtlas = 0;
+	const uint8_t* overlayAtlasPixels = nullptr;    // Font pixels last uploaded to overlayAtlas
+	std::vector<float> overlayVertices;
+	ChromeTrace trace;
+	int traceFrames = 300;
+	bool hiddenWindow = false;              // Benchmark with the GL renderer
+	bool nullRenderer = false;              // Benchmark without GL
+	float nullVertices[8] = {};             // Where the null renderer copies each draw
+	Replay replay;                          // With --record
+	bool recording = false;
+	std::chrono::steady_clock::time_point lastFrameStart;
+	bool firstFrameDone = false;
+	bool startupReported = false;
+	int audioBufferFrames = 4096;
+	bool audioReport = false;
 	bool appIsRunning = true;
 	bool gameIsPaused = false;
 	bool gameOver = false;
@@ -210,233 +197,595 @@ namespace Global
 	unsigned int fruitSpawnTime = 0;
 	unsigned int fruitLifeSpan = 15000;
 	bool startGame = false;
+	SimRandom rng = SimRandom{0x9E3779B97F4A7C15ull};
+	unsigned int gameOverTime = 0;
+	unsigned int roundStartTime = 0;
+	Autopilot* autopilot = nullptr;
+	GameState* autopilotState = nullptr;
+	unsigned int decisionInterval = 50;
+	unsigned int nextDecisionTime = 0;
 };
 
-struct Transform
+
+
+// **********************************************************************************************
+//	Visual and Audio
+// **********************************************************************************************
+
+void RenderEntity(Entity& entity)
 {
-	Transform()
+	if (Global::nullRenderer)
 	{
-		position = Vector();
+		// Keep the vertex copy glBufferData would make, skip the GL calls
+		std::copy(entity.vertices, entity.vertices + 8, Global::nullVertices);
+		return;
 	}
-	
-	explicit Transform(const Vector& _position) : position (_position){}
-	Vector position;
+	glBindBuffer(GL_ARRAY_BUFFER, Global::VBO);
+	glBufferData(GL_ARRAY_BUFFER, 4 * 2 * sizeof(float), entity.vertices, GL_DYNAMIC_DRAW);
+		
+	// render here
+	glUseProgram(Global::shader);
+	glBindVertexArray(Global::VAO);
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	Metrics::Get().Add(METRIC_DRAW_CALLS);
+	glBindVertexArray(0);
+}
+
+void RenderText()
+{
+	// Fixed buffers: this runs every frame and must not allocate
+	char scoreText[32], highScoreText[32];
+	std::snprintf(scoreText, sizeof(scoreText), "Score: %u", Global::score);
+	std::snprintf(highScoreText, sizeof(highScoreText), "High Score: %u", Global::highScore);
+}
+
+// Maps assets.pak from the executable's directory, so the game runs from any working directory
+void OpenAssets()
+{
+	char* base = SDL_GetBasePath();
+	Global::basePath = base ? base : "";
+	SDL_free(base);
+	if (!Global::assets.Open((Global::basePath + "assets.pak").c_str()))
+		std::cout << "No assets.pak next to the executable, loading loose files from ../assets" << std::endl;
+}
 
-	[[nodiscard]] float* GenQuadVertices(float rad) const
+// Loose-file fallback for assets missing from the archive
+std::string AssetPath(const char* name)
+{
+	return Global::basePath + "../assets/" + name;
+}
+
+// With --hot-reload, a loose file saved while the game runs replaces the archived one
+bool IsEditedAsset(const char* name)
+{
+	return Global::editedAssets.count(name) != 0;
+}
+
+// Reads an asset straight out of the mapped archive, or opens the loose file. Free with SDL_RWclose.
+SDL_RWops* OpenAssetRW(const char* name)
+{
+	if (IsEditedAsset(name))
+		return SDL_RWFromFile(AssetPath(name).c_str(), "rb");
+	AssetView view = Global::assets.Find(name);
+	if (view.data != nullptr)
+		return SDL_RWFromConstMem(view.data, (int)view.size);
+	return SDL_RWFromFile(AssetPath(name).c_str(), "rb");
+}
+
+// Whole asset as text, for shader sources
+bool ReadAssetText(const char* name, std::string& text)
+{
+	SDL_RWops* file = OpenAssetRW(name);
+	if (file == nullptr)
+		return false;
+	Sint64 size = SDL_RWsize(file);
+	text.assign(size > 0 ? (size_t)size : 0, '\0');
+	bool ok = size >= 0 && SDL_RWread(file, &text[0], 1, text.size()) == text.size();
+	SDL_RWclose(file);
+	return ok;
+}
+
+// Builds a program from two shader assets; 0 if a file is missing or does not compile
+unsigned int LoadShaderProgram(const char* vertexName, const char* fragmentName)
+{
+	std::string vertex, fragment;
+	if (!ReadAssetText(vertexName, vertex) || !ReadAssetText(fragmentName, fragment))
 	{
-		return new float[8]{
-			position.x - rad, position.y + rad,
-			position.x + rad, position.y + rad,
-			position.x - rad, position.y - rad,
-			position.x + rad, position.y - rad
-		};
+		std::cout << "Failed to read shaders " << vertexName << ", " << fragmentName << std::endl;
+		return 0;
 	}
+	return SetUpShaders(vertex, fragment);
+}
 
-	void Translate(float*& verts, float dX, float dY)
+// High scores and statistics live in the per-user data directory SDL picks for the platform
+void OpenScores()
+{
+	char* prefPath = SDL_GetPrefPath("", "SnakeGame");
+	if (prefPath == nullptr)
 	{
-		position.x += dX;
-		position.y += dY;
-		for (int i=0; i < 8; i++){
-			if(i%2 == 0)
-				verts[i] += dX;
-			else
-				verts[i] += dY;
-		}
+		std::cout << "No writable data directory, scores will not be saved: " << SDL_GetError() << std::endl;
+		return;
 	}
+	Global::scores.Open(std::string(prefPath) + "scores.log");
+	SDL_free(prefPath);
+}
 
-	static void Rotate(float* verts, float angle)
-	{
-		float arr[8] = {
-			verts[0] * std::cos(angle) + verts[1] * -1 * std::sin(angle),
-			verts[0] * std::sin(angle) + verts[1] * std::cos(angle),
-			verts[2] * std::cos(angle) + verts[3] * -1 * std::sin(angle),
-			verts[2] * std::sin(angle) + verts[3] * std::cos(angle),
-			verts[4] * std::cos(angle) + verts[5] * -1 * std::sin(angle),
-			verts[4] * std::sin(angle) + verts[5] * std::cos(angle),
-			verts[6] * std::cos(angle) + verts[7] * -1 * std::sin(angle),
-			verts[6] * std::sin(angle) + verts[7] * std::cos(angle)
-		};
-		verts[0] = arr[0];
-		verts[1] = arr[1];
-		verts[2] = arr[2];
-		verts[3] = arr[3];
-		verts[4] = arr[4];
-		verts[5] = arr[5];
-		verts[6] = arr[6];
-		verts[7] = arr[7];
-	}
-
-	static void Scale(float* verts, float sX, float sY)
-	{
-		for (int i=0; i < 8; i++){
-			if(i%2 == 0)
-				verts[i] *= sX;
-			else
-				verts[i] *= sY;
-		}
-	}
-};
+// Glyph atlases only come baked (BakeAssets), the game has no font rasterizer of its own
+void LoadFont(const char* name)
+{
+	Global::fontLoaded = ReadFontAtlas(Global::assets.Find(BakedAssetName(name, ".atlas").c_str()), Global::font);
+	if (!Global::fontLoaded)
+		std::cout << "No baked atlas for font " << name << ", run BakeAssets" << std::endl;
+}
 
-struct Entity
+// Stages a sound in the sample pool in the obtained device format. Baked PCM that already
+// matches the device is copied as is; otherwise the WAV is decoded and converted, in place
+// when it comes from the archive.
+void LoadAudio(SamplePool& pool, const char* name)
 {
-    Entity() 
+	BakedPcmView baked;
+	if (!IsEditedAsset(name) && ReadBakedPcm(Global::assets.Find(BakedAssetName(name, ".pcm").c_str()), baked)
+		&& (int)baked.header.frequency == Global::audioSpec.freq && baked.header.channels == Global::audioSpec.channels
+		&& Global::audioSpec.format == AUDIO_S16SYS)
 	{
-		transform = Transform();
-		setVertices();
+		SDL_AudioSpec bakedSpec = Global::audioSpec;
+		pool.StageConverted(name, baked.samples, baked.header.frames, baked.header.channels,
+			baked.header.frames * baked.header.channels * (Uint32)sizeof(Sint16), bakedSpec);
+		return;
 	}
 
-    explicit Entity(const Vector& _position, float scaleF = 0.025f)
+	AssetView view = IsEditedAsset(name) ? AssetView{nullptr, 0} : Global::assets.Find(name);
+	WavInfo wav;
+	if (view.data != nullptr && ParseWav(view.data, view.size, wav))
 	{
-		transform = Transform(_position);
-        scaleFactor = scaleF;
-		setVertices(scaleFactor);
+		if (pool.Stage(name, wav.pcm, wav.bytes, wav.spec, Global::audioSpec) < 0)
+			std::cout << "Failed to convert Audio: " << SDL_GetError() << std::endl;
+		return;
 	}
-    
-	Entity(const Entity& e, float scaleF = 0.025f)
+
+    SDL_AudioSpec spec;
+    Uint8* data;
+    Uint32 length;
+    if (SDL_LoadWAV_RW(OpenAssetRW(name), 1, &spec, &data, &length) == nullptr)
+    {
+		std::cout << "Failed to load Audio: " << SDL_GetError() << std::endl;
+		return;
+    }
+
+	if (pool.Stage(name, data, length, spec, Global::audioSpec) < 0)
+		std::cout << "Failed to convert Audio: " << SDL_GetError() << std::endl;
+	SDL_FreeWAV(data);
+}
+
+// Packs the staged clips into one block and hands them to the mixer
+void FinishLoadingAudio()
+{
+	Global::samplePool.Pack();
+	for (int i = 0; i < (int)Global::samplePool.Clips(); i++)
 	{
-		transform = e.transform;
-        scaleFactor = e.scaleFactor;
-		setVertices(scaleFactor);
+		AudioSource sound;
+		sound.data = Global::samplePool.Samples(i);
+		sound.frames = Global::samplePool.Frames(i);
+		sound.clip = Global::mixer.AddClip(sound.data, sound.frames);
+		Global::audioSources.push_back(sound);
 	}
-	
-	Entity& operator=(const Entity& other) 
-	{
-        if (this == &other) {
-            return *this; // Self-assignment, no need to do anything
-        }
+	if (Global::audioReport)
+		Global::samplePool.Report(std::cout);
+}
 
-        transform = other.transform;
-        scaleFactor = other.scaleFactor;
-        setVertices(scaleFactor);
-        return *this;
-    }
+// Synthesized effects climb in pitch as the score grows, up to an octave
+float ScorePitch()
+{
+	return 1.0f + 0.04f * (float)std::min(Global::score, 25u);
+}
 
-    ~Entity()= default;
-    Transform transform;
-	float* vertices{};
-	Vector oldPosition;
-	float scaleFactor;
+void PlayCollisionSound()
+{
+	if (!Global::audioTask.Ready())
+		return;
+	if (Global::synthAudio)
+		Global::synth.Trigger(EAT_PATCH, EffectPitch(Global::difficulty) * ScorePitch());
+    else if (!Global::audioSources.empty())
+		Global::mixer.Play(Global::audioSources[0].clip, 1.0f, EffectPitch(Global::difficulty));
+}
+
+void PlayGameOverSound()
+{
+	if (!Global::audioTask.Ready())
+		return;
+	if (Global::synthAudio)
+		Global::synth.Trigger(GAME_OVER_PATCH);
+    else if (!Global::audioSources.empty() && Global::audioSources.size() > 1)
+		Global::mixer.Play(Global::audioSources[1].clip);
+}
 
-	void setVertices(float scaleF = 0.025f)
+// Brings up one SDL subsystem the first time a feature needs it, timed as its own startup phase.
+// Call from one thread at a time: SDL's subsystem reference counts are not thread-safe.
+bool InitSubsystem(Uint32 flag, const char* phaseName)
+{
+	if (SDL_WasInit(flag) == flag)
+		return true;
+	TimelinePhase phase(Global::timeline, phaseName);
+	if (SDL_InitSubSystem(flag) != 0)
 	{
-		vertices = transform.GenQuadVertices(scaleF);
-        scaleFactor = scaleF;
+		std::cout << "Error Initializing SDL (" << phaseName << "): " << SDL_GetError() << std::endl;
+		return false;
 	}
+	return true;
+}
+
+// Runs on Global::audioTask's thread
+void SetUpAudio()
+{
+	TimelinePhase phase(Global::timeline, "audio (async)");
+	Profiler::Get().NameThread("audio loader");
+	PROFILE_SCOPE("audio setup");
+	if (!InitSubsystem(SDL_INIT_AUDIO, "SDL audio init"))
+		return;
+		// Set audio specifications
+	SDL_AudioSpec want;
+	SDL_memset(&want, 0, sizeof(want));
+	want.freq = 44100;  // Sample rate
+	want.format = AUDIO_S16SYS;  // Sample format
+	want.channels = 2;  // Number of audio channels
+	want.samples = (Uint16)Global::audioBufferFrames;  // Audio buffer size, 4096 or 256-512 in low-latency mode
+	want.callback = AudioMixer::Callback;
+	want.userdata = &Global::mixer;
+
+	// Keep signed 16-bit for the mixer, take whatever rate and channel count the hardware prefers
+	SDL_AudioSpec have;
+	Global::audioDevice = SDL_OpenAudioDevice(nullptr, 0, &want, &have, SDL_AUDIO_ALLOW_FREQUENCY_CHANGE | SDL_AUDIO_ALLOW_CHANNELS_CHANGE);
 
-	void printEntity() const
+	if (Global::audioDevice == 0)
 	{
-		std::cout << transform.position.x << ", " << transform.position.y << std::endl;
-		for (int i=0; i < 8;){
-			std::cout << vertices[i++] << ", "<< vertices[i++] << std::endl;
-		}
-		std::cout << "\n";
+		std::cerr << "Failed to open audio: " << SDL_GetError() << std::endl;
+		return;
 	}
+	Global::audioSpec = have;
+	Global::mixer.SetFormat(have.channels, have.samples, have.freq);
 
-	void SetPosition(float x, float y, float scale = 0.25f)
+	// Either load the effect clips or generate them in the callback
+	Uint64 effectsStart = SDL_GetPerformanceCounter();
+	size_t effectsBytes = 0;
+	if (Global::synthAudio)
+	{
+		Global::synth.SetFormat(have.channels, have.freq);
+		Global::mixer.SetStream(STREAM_SYNTH, &Global::synth, 1.0f);
+		effectsBytes = ChipSynth::FootprintBytes();
+	}
+	else
+	{
+		for (const char* name : EFFECT_ASSETS)
+			LoadAudio(Global::samplePool, name);
+		FinishLoadingAudio();
+		effectsBytes = Global::samplePool.Bytes();
+	}
+	if (Global::audioReport)
 	{
-		oldPosition = transform.position;
-		transform.position.x = x;
-		transform.position.y = y;
-		setVertices(scale);
+		double effectsMs = (double)(SDL_GetPerformanceCounter() - effectsStart) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+		std::cout << "[Audio] " << (Global::synthAudio ? "synthesized" : "WAV") << " effects ready in " << effectsMs
+			<< " ms, " << effectsBytes << " bytes resident" << std::endl;
 	}
 
-	void SetPosition(const Vector& v, float scaleF = 0.25f)
+	// Long tracks are streamed from a memory-mapped file instead of going through LoadAudio
+	if (!Global::musicPath.empty() && Global::music.Open(Global::musicPath.c_str(), Global::audioSpec))
 	{
-		oldPosition = transform.position;
-		transform.position = v;
-		setVertices(scaleF);
+		Global::music.Start();
+		Global::mixer.SetMusic(&Global::music);
 	}
-	
-	void SetOldPosition(const Vector& pos)
+
+	// Clips are registered, the callback may start mixing
+	SDL_PauseAudioDevice(Global::audioDevice, 0);
+}
+
+void CleanUpAudio()
+{
+	Global::audioTask.Wait();
+	if (Global::audioDevice != 0)
+		SDL_CloseAudioDevice(Global::audioDevice);
+	Global::mixer.SetMusic(nullptr);
+	Global::mixer.SetStream(STREAM_SYNTH, nullptr, 1.0f);
+	if (Global::audioReport)
 	{
-		oldPosition = pos;
+		Global::mixer.Report(std::cout);
+		if (!Global::musicPath.empty())
+			Global::music.Report(std::cout);
 	}
-};
+	Global::music.Stop();
+}
 
 // **********************************************************************************************
-//	Visual and Audio
+//	Profiler Overlay
 // **********************************************************************************************
 
-void RenderEntity(Entity& entity)
+// Created the first time the overlay is shown
+void SetUpOverlay()
 {
-	glBindBuffer(GL_ARRAY_BUFFER, Global::VBO);
-	glBufferData(GL_ARRAY_BUFFER, 4 * 2 * sizeof(float), entity.vertices, GL_DYNAMIC_DRAW);
-		
-	// render here
-	glUseProgram(Global::shader);
-	glBindVertexArray(Global::VAO);
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	Global::overlayShader = LoadShaderProgram(OVERLAY_VERTEX_SHADER_ASSET, OVERLAY_FRAGMENT_SHADER_ASSET);
+
+	// Interleaved position, texture coordinates and color
+	glGenVertexArrays(1, &Global::overlayVAO);
+	glBindVertexArray(Global::overlayVAO);
+	glGenBuffers(1, &Global::overlayVBO);
+	glBindBuffer(GL_ARRAY_BUFFER, Global::overlayVBO);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 8, (void*)0);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 8, (void*)(sizeof(float) * 2));
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(float) * 8, (void*)(sizeof(float) * 4));
 	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glGenTextures(1, &Global::overlayAtlas);
 }
 
-void RenderText()
+void CleanUpOverlay()
 {
-	std::string scoreText = "Score: " + std::to_string(Global::score);
-	std::string highScoreText = "High Score: " + std::to_string(Global::highScore);
+	glDeleteProgram(Global::overlayShader);
+	glDeleteVertexArrays(1, &Global::overlayVAO);
+	glDeleteBuffers(1, &Global::overlayVBO);
+	glDeleteTextures(1, &Global::overlayAtlas);
 }
 
-void LoadAudio(const char* filename)
+// Uploads the glyph atlas once the font task has it, and again when a hot reload replaced it
+void UpdateOverlayAtlas()
 {
-    SDL_AudioSpec spec;
-    Uint8* data;
-    Uint32 length;
-    if (SDL_LoadWAV(filename, &spec, &data, &length) != nullptr)
-    {
-        AudioSource sound;
-        sound.data = data;
-        sound.length = length;
-        sound.spec = spec;
-        Global::audioSources.push_back(sound);
-    }else
-		std::cout << "Failed to load Audio: " << SDL_GetError() << std::endl;
+	if (!Global::fontTask.Ready() || !Global::fontLoaded || Global::font.pixels == Global::overlayAtlasPixels)
+		return;
+	glBindTexture(GL_TEXTURE_2D, Global::overlayAtlas);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, Global::font.header.atlasWidth, Global::font.header.atlasHeight, 0, GL_RED,
+		GL_UNSIGNED_BYTE, Global::font.pixels);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	Global::overlayAtlasPixels = Global::font.pixels;
 }
 
-void PlayCollisionSound()
+// Window pixels, y down. u0 < 0 draws a solid quad.
+void PushOverlayQuad(float x0, float y0, float x1, float y1, float u0, float v0, float u1, float v1, const float* rgba)
 {
-    if (!Global::audioSources.empty())
-    {
-        SDL_AudioSpec spec = Global::audioSources[0].spec;
-        SDL_QueueAudio(Global::audioDevice, Global::audioSources[0].data, Global::audioSources[0].length);
-        SDL_PauseAudioDevice(Global::audioDevice, 0);
-    }
+	float left = x0 / WIDTH * 2.0f - 1.0f, right = x1 / WIDTH * 2.0f - 1.0f;
+	float top = 1.0f - y0 / HEIGHT * 2.0f, bottom = 1.0f - y1 / HEIGHT * 2.0f;
+	const float corners[6][4] = {{left, top, u0, v0}, {right, top, u1, v0}, {left, bottom, u0, v1},
+		{right, top, u1, v0}, {right, bottom, u1, v1}, {left, bottom, u0, v1}};
+	for (const auto& corner : corners)
+	{
+		Global::overlayVertices.insert(Global::overlayVertices.end(), corner, corner + 4);
+		Global::overlayVertices.insert(Global::overlayVertices.end(), rgba, rgba + 4);
+	}
 }
 
-void PlayGameOverSound()
+void PushOverlayText(float x, float baseline, const char* text, const float* rgba)
 {
-    if (!Global::audioSources.empty() && Global::audioSources.size() > 1)
-    {
-        SDL_AudioSpec spec = Global::audioSources[1].spec;
-        SDL_QueueAudio(Global::audioDevice, Global::audioSources[1].data, Global::audioSources[1].length);
-        SDL_PauseAudioDevice(Global::audioDevice, 0);
-    }
+	if (Global::overlayAtlasPixels == nullptr)
+		return;
+	float atlasWidth = Global::font.header.atlasWidth, atlasHeight = Global::font.header.atlasHeight;
+	for (; *text != '\0'; text++)
+	{
+		const GlyphMetrics* glyph = Global::font.Glyph(*text);
+		if (glyph == nullptr)
+			continue;
+		if (glyph->width > 0)
+		{
+			float left = x + glyph->bearingX, top = baseline - glyph->bearingY;
+			PushOverlayQuad(left, top, left + glyph->width, top + glyph->height, glyph->x / atlasWidth, glyph->y / atlasHeight,
+				(glyph->x + glyph->width) / atlasWidth, (glyph->y + glyph->height) / atlasHeight, rgba);
+		}
+		x += glyph->advance;
+	}
 }
 
-void SetUpAudio()
+// One line per scope: name and last frame's milliseconds, and a bar against the 60 Hz budget.
+// Allocation tracking builds add a line with the last frame's allocations. Labels need the
+// baked font; without it only the bars are drawn.
+void RenderProfilerOverlay()
 {
-		// Set audio specifications
-	SDL_AudioSpec want, have;
-	SDL_memset(&want, 0, sizeof(want));
-	want.freq = 44100;  // Sample rate
-	want.format = AUDIO_S16SYS;  // Sample format
-	want.channels = 2;  // Number of audio channels
-	want.samples = 4096;  // Audio buffer size
+	if (!Global::profilerOverlay || Global::overlayShader == 0)
+		return;
+	UpdateOverlayAtlas();
+	Global::gpuTimers.Begin("overlay");
 
-	Global::audioDevice = SDL_OpenAudioDevice(nullptr, 0, &want, nullptr, 0);
+	const float cpuColor[4] = {0.2f, 0.9f, 0.3f, 1.0f}, gpuColor[4] = {1.0f, 0.6f, 0.1f, 1.0f};
+	const float textColor[4] = {1.0f, 1.0f, 1.0f, 1.0f}, panelColor[4] = {0.0f, 0.0f, 0.0f, 0.6f};
+	const float budgetMs = 1000.0f / 60.0f, barX = 190.0f, barWidth = 200.0f;
+	const Profiler& profiler = Profiler::Get();
+	float lineHeight = Global::overlayAtlasPixels != nullptr ? (float)std::max<int16_t>(Global::font.header.lineHeight, 8) : 10.0f;
 
-	if (Global::audioDevice == 0)
+	int lines = profiler.ScopeCount() + (ALLOC_TRACKING ? 1 : 0);
+	char label[96];
+
+	Global::overlayVertices.clear();
+	PushOverlayQuad(4.0f, 4.0f, barX + barWidth + 8.0f, 8.0f + lineHeight * lines, -1.0f, -1.0f, -1.0f, -1.0f, panelColor);
+	for (int i = 0; i < profiler.ScopeCount(); i++)
 	{
-		std::cerr << "Failed to open audio: " << SDL_GetError() << std::endl;
+		const Profiler::Scope& scope = profiler.Scopes()[i];
+		float top = 6.0f + lineHeight * i;
+		std::snprintf(label, sizeof(label), "%s %s %.2f ms", scope.gpu ? "gpu" : "cpu", scope.name, scope.lastMs);
+		PushOverlayText(8.0f, top + lineHeight * 0.8f, label, textColor);
+		float length = barWidth * std::min(1.0f, (float)scope.lastMs / budgetMs);
+		PushOverlayQuad(barX, top + 2.0f, barX + std::max(length, 1.0f), top + lineHeight - 2.0f, -1.0f, -1.0f, -1.0f, -1.0f,
+			scope.gpu ? gpuColor : cpuColor);
+	}
+	if (ALLOC_TRACKING)
+	{
+		const AllocCounts& frame = AllocTracker::Get().LastFrame();
+		std::snprintf(label, sizeof(label), "alloc %llu  %llu bytes  free %llu", (unsigned long long)frame.allocs,
+			(unsigned long long)frame.bytes, (unsigned long long)frame.frees);
+		PushOverlayText(8.0f, 6.0f + lineHeight * (lines - 1) + lineHeight * 0.8f, label, textColor);
+	}
+
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glUseProgram(Global::overlayShader);
+	glBindTexture(GL_TEXTURE_2D, Global::overlayAtlas);
+	glBindVertexArray(Global::overlayVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, Global::overlayVBO);
+	glBufferData(GL_ARRAY_BUFFER, Global::overlayVertices.size() * sizeof(float), Global::overlayVertices.data(), GL_STREAM_DRAW);
+	glDrawArrays(GL_TRIANGLES, 0, (GLsizei)(Global::overlayVertices.size() / 8));
+	Metrics::Get().Add(METRIC_DRAW_CALLS);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glDisable(GL_BLEND);
+	Global::gpuTimers.End();
+}
+
+// F3: the profiler starts with the first time the overlay is shown and keeps recording after
+void ToggleProfilerOverlay()
+{
+	Global::profilerOverlay = !Global::profilerOverlay;
+	if (!Global::profilerOverlay)
+		return;
+	Profiler::Get().SetEnabled(true);
+	if (Global::overlayVAO == 0)
+		SetUpOverlay();
+}
+
+// **********************************************************************************************
+//	Hot Reload
+// **********************************************************************************************
+
+// Roots given to Global::watcher
+enum eWatchRoot {WATCH_ASSETS = 0, WATCH_ARCHIVE};
+
+// A failed compile keeps the running program, so a typo never blanks the screen
+void ReloadProgram(unsigned int& current, const char* vertexName, const char* fragmentName)
+{
+	unsigned int program = LoadShaderProgram(vertexName, fragmentName);
+	if (program == 0)
+	{
+		std::cout << "Shader reload failed, keeping the previous program" << std::endl;
 		return;
 	}
+	glDeleteProgram(current);
+	current = program;
+	std::cout << "Reloaded " << vertexName << ", " << fragmentName << std::endl;
+}
 
-	// Load audio files
-	LoadAudio("../assets/audio/carrotnom-92106.wav");
-	LoadAudio("../assets/audio/mixkit-retro-game-over-1947.wav");
+void ReloadShaders()
+{
+	ReloadProgram(Global::shader, VERTEX_SHADER_ASSET, FRAGMENT_SHADER_ASSET);
+	if (Global::overlayShader != 0)
+		ReloadProgram(Global::overlayShader, OVERLAY_VERTEX_SHADER_ASSET, OVERLAY_FRAGMENT_SHADER_ASSET);
 }
 
-void CleanUpAudio()
+// Decodes every effect into a fresh pool on a worker thread; SwapReloadedAudio installs it
+void StartAudioReload()
 {
-	SDL_CloseAudioDevice(Global::audioDevice);
+	if (Global::synthAudio || Global::audioDevice == 0)
+		return;
+	Global::reloadPool = SamplePool();
+	Global::audioReloading = true;
+	Global::audioReloadTask.Start([] {
+		Profiler::Get().NameThread("audio loader");
+		PROFILE_SCOPE("audio reload");
+		for (const char* name : EFFECT_ASSETS)
+			LoadAudio(Global::reloadPool, name);
+		Global::reloadPool.Pack();
+	});
+}
+
+// Points the mixer at the reloaded clips under the audio lock, then frees the old samples.
+// Keeps the current clips if any effect failed to load.
+void SwapReloadedAudio()
+{
+	Global::audioReloading = false;
+	if (Global::reloadPool.Clips() != Global::audioSources.size())
+	{
+		std::cout << "Audio reload failed, keeping the previous clips" << std::endl;
+		Global::reloadPool = SamplePool();
+		return;
+	}
+
+	SDL_LockAudioDevice(Global::audioDevice);
+	std::swap(Global::samplePool, Global::reloadPool);
+	for (size_t i = 0; i < Global::audioSources.size(); i++)
+	{
+		AudioSource& sound = Global::audioSources[i];
+		sound.data = Global::samplePool.Samples((int)i);
+		sound.frames = Global::samplePool.Frames((int)i);
+		Global::mixer.ReplaceClip(sound.clip, sound.data, sound.frames);
+	}
+	SDL_UnlockAudioDevice(Global::audioDevice);
+	Global::reloadPool = SamplePool();
+	std::cout << "Reloaded audio" << std::endl;
+}
+
+// Runs on the main thread at the top of every frame, so a frame is drawn and mixed entirely
+// with the old assets or entirely with the new ones
+void ApplyAssetChanges()
+{
+	if (!Global::watcher.IsRunning())
+		return;
+	if (Global::audioReloading && Global::audioReloadTask.Ready())
+		SwapReloadedAudio();
+	// Loader tasks own the archive and what they load while they run; changes wait for them
+	if ((Global::audioEnabled && !Global::audioTask.Ready()) || !Global::fontTask.Ready() || Global::audioReloading)
+		return;
+
+	bool shaders = false, audio = false, font = false;
+	for (const AssetChange& change : Global::watcher.TakeChanges())
+	{
+		if (change.root == WATCH_ARCHIVE)
+		{
+			if (change.name != "assets.pak")
+				continue;
+			// Rewritten by PackAssets or BakeAssets: remap it and drop every view into the old mapping
+			OpenAssets();
+			shaders = audio = font = true;
+			continue;
+		}
+
+		std::string extension = change.name.substr(std::min(change.name.find_last_of('.'), change.name.size()));
+		if (extension == ".vert" || extension == ".frag")
+			shaders = true;
+		else if (extension == ".wav")
+			audio = true;
+		else if (extension == ".ttf")
+			std::cout << change.name << " changed, run BakeAssets to rebake its atlas" << std::endl;
+		else
+			continue;
+		Global::editedAssets.insert(change.name);
+	}
+
+	if (shaders)
+		ReloadShaders();
+	if (audio)
+		StartAudioReload();
+	if (font)
+		LoadFont(FONT_ASSET);
+}
+
+// **********************************************************************************************
+//	Live Metrics
+// **********************************************************************************************
+
+// Adds what other modules already count and serves everything on socketPath
+void SetUpMetrics(const std::string& socketPath)
+{
+	Metrics& metrics = Metrics::Get();
+	metrics.AddSampler("snake_audio_underruns_total", "counter", "Audio device underruns",
+		[] { return (double)Global::mixer.Underruns(); });
+	metrics.AddSampler("snake_allocations_total", "counter", "Heap allocations, counted in -DSNAKE_TRACK_ALLOCS builds",
+		[] { return (double)AllocTracker::Get().Totals().allocs; });
+	metrics.AddSampler("snake_allocated_bytes_total", "counter", "Heap bytes allocated, counted in -DSNAKE_TRACK_ALLOCS builds",
+		[] { return (double)AllocTracker::Get().Totals().bytes; });
+	metrics.Start(socketPath);
+}
+
+// Main thread, at the start of every frame
+void RecordFrameMetrics(const std::vector<Entity>& tails)
+{
+	auto now = std::chrono::steady_clock::now();
+	Metrics& metrics = Metrics::Get();
+	if (Global::lastFrameStart.time_since_epoch().count() != 0)
+		metrics.ObserveFrameMs(std::chrono::duration<double, std::milli>(now - Global::lastFrameStart).count());
+	Global::lastFrameStart = now;
+	metrics.Add(METRIC_FRAMES);
+	metrics.Set(GAUGE_SNAKE_LENGTH, (int64_t)tails.size() + 1);
+	metrics.Set(GAUGE_SCORE, Global::score);
 }
 
 // **********************************************************************************************
@@ -445,18 +794,43 @@ void CleanUpAudio()
 
 inline int SetUpApp(SDL_Window*& window, SDL_GLContext& context)
 {
-	if (SDL_Init(SDL_INIT_EVERYTHING) != 0)
+	// Subsystems come up on demand: video (and events) here for the window, audio on the audio
+	// task only when sound is enabled. Joystick, haptic, game controller and sensor are never
+	// needed, the game is played from the keyboard.
+	int sdlPhase = Global::timeline.Begin("SDL_Init");
+	if (SDL_Init(0) != 0)
 	{
 		std::cout << "Error Initializing SDL: " << SDL_GetError() << std::endl;
 		return FAILED;
 	}
+	Global::timeline.End(sdlPhase);
+	if (!InitSubsystem(SDL_INIT_VIDEO, "SDL video init"))
+		return FAILED;
 
 	// if (TTF_Init() == -1) {
 	// 	std::cerr << "TTF_Init failed: " << TTF_GetError() << std::endl;
 	// }
 
-	// Setup Sound  here
-	SetUpAudio();
+	{
+		TimelinePhase phase(Global::timeline, "open assets");
+		OpenAssets();
+	}
+	{
+		TimelinePhase phase(Global::timeline, "score log");
+		OpenScores();
+	}
+
+	// Sound and fonts are not needed for the first frame, load them while the window comes up
+	if (Global::audioEnabled)
+		Global::audioTask.Start(SetUpAudio);
+	Global::fontTask.Start([] {
+		TimelinePhase phase(Global::timeline, "font (async)");
+		Profiler::Get().NameThread("font loader");
+		PROFILE_SCOPE("font load");
+		LoadFont(FONT_ASSET);
+	});
+
+	int windowPhase = Global::timeline.Begin("window + GL context");
 
 	SDL_GL_SetAttribute(SDL_GL_RED_SIZE, 8);
 	SDL_GL_SetAttribute(SDL_GL_BLUE_SIZE, 8);
@@ -472,7 +846,8 @@ inline int SetUpApp(SDL_Window*& window, SDL_GLContext& context)
 	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
 	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
 
-	window = SDL_CreateWindow("Snake Game", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, WIDTH, HEIGHT, SDL_WINDOW_OPENGL);
+	window = SDL_CreateWindow("Snake Game", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, WIDTH, HEIGHT,
+		SDL_WINDOW_OPENGL | (Global::hiddenWindow ? SDL_WINDOW_HIDDEN : 0));
 
 	if (!window)
 	{
@@ -491,6 +866,8 @@ inline int SetUpApp(SDL_Window*& window, SDL_GLContext& context)
 		std::cout << "Error Initializing GLEW" << std::endl;
 		return FAILED;
 	}
+	Global::timeline.End(windowPhase);
+	TimelinePhase phase(Global::timeline, "GL buffers + shaders");
 	
 	// Explicit VAO creation
 	glGenVertexArrays(1, &Global::VAO);
@@ -506,51 +883,105 @@ inline int SetUpApp(SDL_Window*& window, SDL_GLContext& context)
 
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-	Global::shader = SetUpShaders(vertexSource, fragmentSource);
+	Global::shader = LoadShaderProgram(VERTEX_SHADER_ASSET, FRAGMENT_SHADER_ASSET);
+	if (Global::shader == 0)
+		return FAILED;
+	Global::gpuTimers.Create();
+	if (Global::profilerOverlay)
+		SetUpOverlay();
+
+	// Watch the loose assets and the archive next to the executable
+	if (Global::hotReload && !Global::watcher.Start({{Global::basePath + "../assets", true}, {Global::basePath, false}}))
+		std::cout << "Hot reload unavailable: cannot watch " << Global::basePath << "../assets" << std::endl;
 	return SUCCESS;
 }
 
 inline void CleanUpApp(SDL_Window*& window, SDL_GLContext& context)
 {
+	Metrics::Get().Stop();
+	Global::watcher.Stop();
+	Global::trace.Stop();
+	Global::trace.Wait();
+	Global::scores.Close();
+	if (Global::statsReport)
+		Global::scores.Report(std::cout);
+	Global::fontTask.Wait();
+	Global::audioReloadTask.Wait();
+	if (Profiler::Get().Enabled())
+		Profiler::Get().Report(std::cout);
+	if (ALLOC_TRACKING)
+		AllocTracker::Get().Report(std::cout);
+	Global::gpuTimers.Destroy();
+	if (Global::overlayVAO != 0)
+		CleanUpOverlay();
 	SDL_GL_DeleteContext(context);
 	SDL_DestroyWindow(window);
 	// CleanUp Audio Device here
 	CleanUpAudio();
+	Global::assets.Close();
 	SDL_Quit();
 }
 
+// Which SDL subsystems startup brought up, and which it never paid for
+void ReportSubsystems(std::ostream& out)
+{
+	const struct { Uint32 flag; const char* name; } subsystems[] = {
+		{SDL_INIT_TIMER, "timer"}, {SDL_INIT_AUDIO, "audio"}, {SDL_INIT_VIDEO, "video"}, {SDL_INIT_EVENTS, "events"},
+		{SDL_INIT_JOYSTICK, "joystick"}, {SDL_INIT_HAPTIC, "haptic"}, {SDL_INIT_GAMECONTROLLER, "game controller"},
+		{SDL_INIT_SENSOR, "sensor"}};
+	std::string initialized, skipped;
+	for (const auto& subsystem : subsystems)
+		(SDL_WasInit(subsystem.flag) == subsystem.flag ? initialized : skipped) += std::string(" ") + subsystem.name;
+	out << "[Startup] SDL subsystems initialized:" << initialized << "\n";
+	out << "[Startup] SDL subsystems not initialized:" << skipped << std::endl;
+}
+
+// Marks the first frame and, once the background loads are done, prints the startup timeline
+void ReportStartup()
+{
+	if (!Global::firstFrameDone)
+	{
+		Global::timeline.Mark("first frame");
+		Global::firstFrameDone = true;
+		std::cout << "[Startup] time to first frame " << Global::timeline.EndOf("first frame") << " ms" << std::endl;
+	}
+	if (Global::startupReport && !Global::startupReported && (!Global::audioEnabled || Global::audioTask.Ready())
+		&& Global::fontTask.Ready())
+	{
+		Global::timeline.Report(std::cout);
+		ReportSubsystems(std::cout);
+		Global::startupReported = true;
+	}
+}
+
 // **********************************************************************************************
 //	Game and Utility Functions
 // **********************************************************************************************
 
-bool HasCollided(Entity& _this, Entity& other)
+Vector GenerateRandomPoint()
 {
-	float distance = Vector::Distance(_this.transform.position, other.transform.position);
-	if (distance < other.scaleFactor * 2)
-		return true;
-	return false; 
+	return GenerateRandomPoint(Global::rng);
 }
 
-Vector GenerateRandomPoint()
+// With --record, adds an input to the current frame of the replay
+void RecordInput(eReplayInput input)
 {
-	std::mt19937 gen(static_cast<unsigned int>(std::time(nullptr)));
-
-    std::uniform_real_distribution<float> distribution(-0.975f, 0.976f);
-
-    float x = distribution(gen);
-    float y = distribution(gen);
-
-    return {x, y};
+	if (Global::recording)
+		Global::replay.AddInput(input);
 }
 
 void GameOver()
 {
 	Global::dir = eDirection::STOP;
 	Global::gameOver = true;
+	Global::gameOverTime = Global::currentTime;
 	if (Global::score > Global::highScore)
 	{
 		Global::highScore = Global::score;
 	}
+	// Attract mode games do not count
+	if (Global::startGame && Global::autopilot == nullptr)
+		Global::scores.RecordGame(Global::difficulty, Global::score, Global::level, Global::currentTime - Global::roundStartTime);
 	Global::level = 1;
 	Global::maxLevelScore = 5;
 	// Play Game Over Sound here;
@@ -563,6 +994,7 @@ void ResetGame()
 	Global::gameOver = false;
 	Global::gameIsPaused = false;
 	Global::score = 0;
+	Global::roundStartTime = Global::currentTime;
 	if (Global::dir != eDirection::DOWN) 
 	{
 		Global::dX = 0.0f; Global::dY = Global::step;
@@ -571,9 +1003,69 @@ void ResetGame()
 	}
 }
 
+// Copies the live game into a GameState that can be forked, simulated and restored later
+void SnapshotGame(GameState& state, const Entity& snake, const Entity& fruit, const std::vector<Entity>& tails)
+{
+	state.head = snake.transform.position;
+	state.headOld = snake.oldPosition;
+	state.fruit = fruit.transform.position;
+	state.tailOffset = Global::tailOffset;
+	state.dX = Global::dX; state.dY = Global::dY;
+	state.step = Global::step;
+	state.dir = Global::dir;
+	state.difficulty = Global::difficulty;
+	state.score = Global::score;
+	state.highScore = Global::highScore;
+	state.level = Global::level;
+	state.maxLevelScore = Global::maxLevelScore;
+	state.currentTime = Global::currentTime;
+	state.fruitSpawnTime = Global::fruitSpawnTime;
+	state.fruitLifeSpan = Global::fruitLifeSpan;
+	state.gameOver = Global::gameOver;
+	state.gameIsPaused = Global::gameIsPaused;
+	state.rng = Global::rng;
+
+	state.tailCount = (uint32_t)std::min(tails.size(), (size_t)MAX_TAIL_SEGMENTS);
+	for (uint32_t i = 0; i < state.tailCount; i++)
+	{
+		state.tails[i].position = tails[i].transform.position;
+		state.tails[i].oldPosition = tails[i].oldPosition;
+	}
+}
+
+void RestoreGame(const GameState& state, Entity& snake, Entity& fruit, std::vector<Entity>& tails)
+{
+	snake.SetPosition(state.head, SNAKE_SCALE);
+	snake.SetOldPosition(state.headOld);
+	fruit.SetPosition(state.fruit, FRUIT_SCALE);
+	Global::tailOffset = state.tailOffset;
+	Global::dX = state.dX; Global::dY = state.dY;
+	Global::step = state.step;
+	Global::dir = state.dir;
+	Global::difficulty = state.difficulty;
+	Global::score = state.score;
+	Global::highScore = state.highScore;
+	Global::level = state.level;
+	Global::maxLevelScore = state.maxLevelScore;
+	Global::currentTime = state.currentTime;
+	Global::fruitSpawnTime = state.fruitSpawnTime;
+	Global::fruitLifeSpan = state.fruitLifeSpan;
+	Global::gameOver = state.gameOver;
+	Global::gameIsPaused = state.gameIsPaused;
+	Global::rng = state.rng;
+
+	tails.resize(state.tailCount);
+	for (uint32_t i = 0; i < state.tailCount; i++)
+	{
+		tails[i].SetPosition(state.tails[i].position, TAIL_SCALE);
+		tails[i].SetOldPosition(state.tails[i].oldPosition);
+	}
+}
+
 void SetDifficulty(eDifficulty d)
 {
 	Global::difficulty = d;
+	Global::highScore = Global::scores.BestScore(d);
 	if (Global::difficulty == eDifficulty::EASY)
 	{
 		Global::step = 0.25f;
@@ -591,8 +1083,53 @@ void SetDifficulty(eDifficulty d)
 	}
 }
 
+// Steering shared by the keyboard and the autopilots
+void ChangeDirection(eDirection d)
+{
+	if (d != eDirection::STOP)
+		RecordInput((eReplayInput)d);
+	Global::gameIsPaused = false;
+	if (d == eDirection::LEFT && Global::dir != eDirection::RIGHT) 
+	{
+		Global::dX = -Global::step; Global::dY = 0.0f;
+		Global::tailOffset = Vector(0.07f, 0.0f);
+		Global::dir = eDirection::LEFT;
+	}
+	else if (d == eDirection::RIGHT && Global::dir != eDirection::LEFT) 
+	{
+		Global::dX = Global::step; Global::dY = 0.0f;
+		Global::tailOffset = Vector(-0.07f, 0.0f);
+		Global::dir = eDirection::RIGHT;
+	}
+	else if (d == eDirection::UP && Global::dir != eDirection::DOWN) 
+	{
+		Global::dX = 0.0f; Global::dY = Global::step;
+		Global::tailOffset = Vector(0.0f, -0.07f);
+		Global::dir = eDirection::UP;
+	}
+	else if (d == eDirection::DOWN && Global::dir != eDirection::UP) 
+	{
+		Global::dX = 0.0f; Global::dY = -Global::step;
+		Global::tailOffset = Vector(0.0f, 0.07f);
+		Global::dir = eDirection::DOWN;
+	}
+}
+
+void RestartGame(Entity& snake, std::vector<Entity>& tails)
+{
+	RecordInput(REPLAY_RESTART);
+	Global::dX = 0.0f; Global::dY = 0.0f; 
+	snake.SetPosition(Vector(), 0.035f);
+	tails.clear();
+	Global::dir = eDirection::STOP;
+	// Reset Fruit LifeSpan
+	Global::fruitSpawnTime = Global::currentTime;
+	ResetGame();
+}
+
 void HandleInput(SDL_Event& event, Entity& snake, std::vector<Entity>& tails)
 {
+	PROFILE_SCOPE("input");
 	while (SDL_PollEvent(&event)) 
 	{
         if (event.type == SDL_QUIT){
@@ -604,15 +1141,10 @@ void HandleInput(SDL_Event& event, Entity& snake, std::vector<Entity>& tails)
 			Global::appIsRunning = false;
 		}else if(event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_RETURN && Global::gameOver)
 		{
-			Global::dX = 0.0f; Global::dY = 0.0f; 
-			snake.SetPosition(Vector(), 0.035f);
-			tails.clear();
-			Global::dir = eDirection::STOP;
-			// Reset Fruit LifeSpan
-			Global::fruitSpawnTime = Global::currentTime;
-			ResetGame();
+			RestartGame(snake, tails);
 		}else if(event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_TAB && Global::gameOver && !Global::tabPressed)
 		{
+			RecordInput(REPLAY_NEXT_DIFFICULTY);
 			int type = ((Global::difficulty + 1) % 3);
 			Global::difficulty = (eDifficulty)type;
 			SetDifficulty(Global::difficulty);
@@ -620,56 +1152,39 @@ void HandleInput(SDL_Event& event, Entity& snake, std::vector<Entity>& tails)
 		}else if (event.type == SDL_KEYUP && event.key.keysym.sym == SDLK_TAB && Global::gameOver)
 		{
 			Global::tabPressed = false;
+		}else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_F3 && event.key.repeat == 0)
+		{
+			ToggleProfilerOverlay();
+		}else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_F4 && event.key.repeat == 0)
+		{
+			Global::trace.Start("trace-" + std::to_string(Profiler::Get().Frames()) + ".json", Global::traceFrames);
 		}
 
 		if (event.type == SDL_KEYDOWN )
 		{
 			if (event.key.keysym.sym == SDLK_LEFT || event.key.keysym.sym == SDLK_a)
 			{
-				Global::gameIsPaused = false;
-				if (Global::dir != eDirection::RIGHT) 
-				{
-					Global::dX = -Global::step; Global::dY = 0.0f;
-					Global::tailOffset = Vector(0.07f, 0.0f);
-					Global::dir = eDirection::LEFT;
-				}
+				ChangeDirection(eDirection::LEFT);
 				break;
 			}
 			else if (event.key.keysym.sym == SDLK_RIGHT || event.key.keysym.sym == SDLK_d)
 			{
-				Global::gameIsPaused = false;
-				if (Global::dir != eDirection::LEFT) 
-				{
-					Global::dX = Global::step; Global::dY = 0.0f;
-					Global::tailOffset = Vector(-0.07f, 0.0f);
-					Global::dir = eDirection::RIGHT;
-				}
+				ChangeDirection(eDirection::RIGHT);
 				break;
 			}
 			else if (event.key.keysym.sym == SDLK_UP || event.key.keysym.sym == SDLK_w)
 			{
-				Global::gameIsPaused = false;
-				if (Global::dir != eDirection::DOWN) 
-				{
-					Global::dX = 0.0f; Global::dY = Global::step;
-					Global::tailOffset = Vector(0.0f, -0.07f);
-					Global::dir = eDirection::UP;
-				}
+				ChangeDirection(eDirection::UP);
 				break;
 			}
 			else if (event.key.keysym.sym == SDLK_DOWN || event.key.keysym.sym == SDLK_s)
 			{
-				Global::gameIsPaused = false;
-				if (Global::dir != eDirection::UP) 
-				{
-					Global::dX = 0.0f; Global::dY = -Global::step;
-					Global::tailOffset = Vector(0.0f, 0.07f);
-					Global::dir = eDirection::DOWN;
-				}
+				ChangeDirection(eDirection::DOWN);
 				break;
 			}
 			else if (event.key.keysym.sym == SDLK_SPACE) 
 			{
+				RecordInput(REPLAY_PAUSE);
 			 	Global::dX = 0.0f; Global::dY = 0.0f; 
 			 	Global::gameIsPaused = true; 
 			 	break;
@@ -689,10 +1204,13 @@ void NewLevel(Entity& snake, std::vector<Entity>& tails)
 
 void UpdateGame(Entity& snake, Entity& fruit, Entity& tail, std::vector<Entity>& tails)
 {
+	PROFILE_SCOPE("update");
 	if (!Global::gameOver)
 	{
 		if (!Global::gameIsPaused)
 		{
+			Metrics::Get().Add(METRIC_TICKS);
+
 			// Calculating Fruit LifeSpan
 			// Fruit must disappear after 10 seconds
 			if (Global::currentTime - Global::fruitSpawnTime > Global::fruitLifeSpan)
@@ -707,26 +1225,14 @@ void UpdateGame(Entity& snake, Entity& fruit, Entity& tail, std::vector<Entity>&
 
 			for (int i = tails.size() - 1; i >= 0; i--)
 			{
-				if (i == 0) 
-				{
-					Vector direction = snake.transform.position - tails[i].transform.position;
-					direction = direction / Vector::Distance(snake.transform.position, tails[i].transform.position);
-					Vector offset = direction * Global::tailSpacing;
-					tails[i].SetPosition(snake.transform.position - offset, 0.030f);
-				} 
-				else 
+				const Vector& leader = (i == 0) ? snake.transform.position : tails[i - 1].transform.position;
+				tails[i].SetPosition(FollowLeader(leader, tails[i].transform.position, Global::tailSpacing), 0.030f);
+
+				// Check collision of snake and its tail
+				if (i > 0 && HasCollided(snake, tails[i])) 
 				{
-					Vector direction = tails[i - 1].transform.position - tails[i].transform.position;
-					direction = direction / Vector::Distance(tails[i - 1].transform.position, tails[i].transform.position);
-					Vector offset = direction * Global::tailSpacing;
-					tails[i].SetPosition(tails[i - 1].transform.position - offset, 0.030f);
-
-					// Check collision of snake and its tail
-					if (HasCollided(snake, tails[i])) 
-					{
-						GameOver();
-						break;
-					}
+					GameOver();
+					break;
 				}
 			}
 
@@ -767,6 +1273,7 @@ void UpdateGame(Entity& snake, Entity& fruit, Entity& tail, std::vector<Entity>&
 
 void RenderGame(Entity& snake, Entity& fruit, std::vector<Entity>& tails)
 {
+	PROFILE_SCOPE("render");
 	RenderEntity(snake);
 	RenderEntity(fruit);
 	for (Entity& tail : tails)
@@ -775,19 +1282,535 @@ void RenderGame(Entity& snake, Entity& fruit, std::vector<Entity>& tails)
 	}
 }
 
+// **********************************************************************************************
+//	Autopilot and Command Line
+// **********************************************************************************************
+
+struct AppOptions
+{
+	std::string autopilot;
+	MctsConfig mcts;
+	int grid = 0;
+	int audioBufferFrames = 4096;
+	bool audioReport = false;
+	bool synthAudio = false;
+	bool startupReport = false;
+	bool noAudio = false;
+	bool hotReload = false;
+	bool statsReport = false;
+	bool profile = false;
+	std::string profileCsv;
+	int traceFrames = 0;
+	std::string musicPath;
+	std::string benchmark;
+	std::string benchRenderer = "gl";
+	int benchFrames = 3000;
+	bool assertNoAlloc = false;
+	std::string metricsPath;
+	std::string recordPath;
+	std::string replays;
+};
+
+// Accepts --autopilot=mcts|path|hamilton, --mcts-playouts=1..10000000, --mcts-time-ms=0..10000,
+// --mcts-trees=1..64, --grid=2..128 (cells per side for path and hamilton), --threads=0..256,
+// --low-latency-audio[=256..512], --audio-report, --music=file.wav (streamed), --synth-audio,
+// --startup-report, --no-audio, --hot-reload, --stats, --profile, --profile-csv=frames.csv,
+// --trace=N (frames from startup to trace.json; F4 captures N more, 300 by default),
+// --benchmark=empty,long-snake,huge-snake|all, --bench-renderer=gl|null, --bench-frames=N,
+// --assert-no-alloc (benchmark fails if a frame allocates; needs -DSNAKE_TRACK_ALLOCS),
+// --metrics=/tmp/snake.sock (serves live metrics on a Unix domain socket),
+// --record=session.replay (writes the session's input at exit), --replay=a.replay,b.replay
+// (benchmarks recorded sessions; combines with --benchmark)
+// Reads the whole of text as a finite number that fits in T; on failure out keeps its value
+template <typename T>
+bool ParseValue(const std::string& text, T& out)
+{
+	if (text.empty() || std::isspace((unsigned char)text[0]))
+		return false;
+	char* end = nullptr;
+	errno = 0;
+	if constexpr (std::is_floating_point_v<T>)
+	{
+		double parsed = std::strtod(text.c_str(), &end);
+		if (*end != '\0' || errno == ERANGE || !std::isfinite(parsed))
+			return false;
+		out = (T)parsed;
+	}
+	else
+	{
+		long long parsed = std::strtoll(text.c_str(), &end, 10);
+		if (*end != '\0' || errno == ERANGE || parsed < (long long)std::numeric_limits<T>::min()
+			|| parsed > (long long)std::numeric_limits<T>::max())
+			return false;
+		out = (T)parsed;
+	}
+	return true;
+}
+
+AppOptions ParseArguments(int argc, char* argv[])
+{
+	AppOptions options;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		std::string value = arg.find('=') != std::string::npos ? arg.substr(arg.find('=') + 1) : "";
+		bool valid = true;
+		if (arg.rfind("--autopilot=", 0) == 0)
+			options.autopilot = value;
+		else if (arg.rfind("--mcts-playouts=", 0) == 0)
+		{
+			valid = ParseValue(value, options.mcts.playouts);
+			options.mcts.playouts = std::clamp(options.mcts.playouts, 1u, 10000000u);
+		}
+		else if (arg.rfind("--mcts-time-ms=", 0) == 0)
+		{
+			valid = ParseValue(value, options.mcts.timeBudgetMs);
+			options.mcts.timeBudgetMs = std::clamp(options.mcts.timeBudgetMs, 0.0, 10000.0);
+		}
+		else if (arg.rfind("--mcts-trees=", 0) == 0)
+		{
+			valid = ParseValue(value, options.mcts.trees);
+			options.mcts.trees = std::clamp(options.mcts.trees, 1u, 64u);
+		}
+		else if (arg.rfind("--grid=", 0) == 0)
+		{
+			// 0 keeps each autopilot's default
+			valid = ParseValue(value, options.grid);
+			options.grid = options.grid > 0 ? std::clamp(options.grid, 2, 128) : 0;
+		}
+		else if (arg == "--low-latency-audio" || arg.rfind("--low-latency-audio=", 0) == 0)
+		{
+			int frames = 256;
+			valid = value.empty() || ParseValue(value, frames);
+			options.audioBufferFrames = std::clamp(frames, 256, 512);
+			options.audioReport = true;
+		}
+		else if (arg.rfind("--music=", 0) == 0)
+			options.musicPath = value;
+		else if (arg == "--audio-report")
+			options.audioReport = true;
+		else if (arg == "--synth-audio")
+			options.synthAudio = true;
+		else if (arg == "--startup-report")
+			options.startupReport = true;
+		else if (arg == "--no-audio")
+			options.noAudio = true;
+		else if (arg == "--hot-reload")
+			options.hotReload = true;
+		else if (arg == "--stats")
+			options.statsReport = true;
+		else if (arg == "--profile")
+			options.profile = true;
+		else if (arg.rfind("--profile-csv=", 0) == 0)
+			options.profileCsv = value;
+		else if (arg.rfind("--trace=", 0) == 0)
+			valid = ParseValue(value, options.traceFrames);
+		else if (arg.rfind("--benchmark=", 0) == 0)
+			options.benchmark = value;
+		else if (arg.rfind("--bench-renderer=", 0) == 0)
+			options.benchRenderer = value;
+		else if (arg.rfind("--bench-frames=", 0) == 0)
+		{
+			valid = ParseValue(value, options.benchFrames);
+			options.benchFrames = std::max(1, options.benchFrames);
+		}
+		else if (arg == "--assert-no-alloc")
+			options.assertNoAlloc = true;
+		else if (arg.rfind("--metrics=", 0) == 0)
+			options.metricsPath = value;
+		else if (arg.rfind("--record=", 0) == 0)
+			options.recordPath = value;
+		else if (arg.rfind("--replay=", 0) == 0)
+			options.replays = value;
+		else if (arg.rfind("--threads=", 0) == 0)
+		{
+			valid = ParseValue(value, options.mcts.threads);
+			options.mcts.threads = std::min(options.mcts.threads, 256u);
+		}
+		else
+			std::cout << "Ignoring unknown argument: " << arg << std::endl;
+		if (!valid)
+			std::cout << "Ignoring bad value in argument: " << arg << std::endl;
+	}
+	return options;
+}
+
+std::unique_ptr<Autopilot> CreateAutopilot(const AppOptions& options)
+{
+	if (options.autopilot == "mcts")
+		return std::unique_ptr<Autopilot>(new MctsAutopilot(options.mcts));
+	if (options.autopilot == "path")
+		return std::unique_ptr<Autopilot>(options.grid > 0 ? new PathAutopilot(options.grid, options.grid) : new PathAutopilot());
+	if (options.autopilot == "hamilton")
+		return std::unique_ptr<Autopilot>(options.grid > 0 ? new HamiltonAutopilot(options.grid, options.grid) : new HamiltonAutopilot());
+	if (!options.autopilot.empty())
+		std::cout << "Unknown autopilot: " << options.autopilot << std::endl;
+	return nullptr;
+}
+
+// Lets the autopilot steer through ChangeDirection and restarts finished rounds (attract mode)
+void UpdateAutopilot(Entity& snake, Entity& fruit, std::vector<Entity>& tails)
+{
+	if (Global::autopilot == nullptr)
+		return;
+	PROFILE_SCOPE("autopilot");
+
+	if (Global::gameOver)
+	{
+		if (Global::currentTime - Global::gameOverTime > 1000)
+			RestartGame(snake, tails);
+		return;
+	}
+
+	if (Global::currentTime < Global::nextDecisionTime)
+		return;
+	Global::nextDecisionTime = Global::currentTime + Global::decisionInterval;
+
+	SnapshotGame(*Global::autopilotState, snake, fruit, tails);
+	ChangeDirection(Global::autopilot->Decide(*Global::autopilotState));
+}
+
+// **********************************************************************************************
+//	Benchmark Mode
+// **********************************************************************************************
+//	--benchmark plays a scripted session for each workload profile through the real HandleInput,
+//	UpdateGame and RenderGame on a fixed 16 ms simulation clock. It reports ticks per second and
+//	frame-time percentiles. The script steers the snake round a square inside the walls by
+//	pushing arrow key events for HandleInput to read. When a round ends, or a new level clears
+//	the tail, the profile is set up again between frames and counted as a reset.
+//
+//	The GL renderer draws into a hidden window and waits for the GPU with glFinish every frame.
+//	The null renderer needs no display and keeps only the vertex copy of each draw.
+//
+//	--replay plays recorded sessions (--record) the same way: each frame pushes the keys of its
+//	inputs and advances the clock by the frame's recorded length, so the session takes the same
+//	course it took when it was played. Resets count the rounds restarted.
+//
+//	Allocation tracking builds count what each timed frame allocates. With --assert-no-alloc a
+//	frame that allocates after the warm-up fails the run. Use the null renderer for that check,
+//	since GL drivers allocate on their own.
+
+struct BenchProfile
+{
+	const char* name;
+	int tailLength;
+};
+
+// The game has no entities besides the snake and one fruit, so load grows with the tail alone
+const BenchProfile BENCH_PROFILES[] = {{"empty", 0}, {"long-snake", 256}, {"huge-snake", 2048}};
+const unsigned int BENCH_TICK_MS = 16;
+const float BENCH_LOOP = 0.8f;          // Half the side of the square the script drives round
+const int BENCH_WARMUP_FRAMES = 60;     // Not checked for allocations
+
+// Head at a corner of the square heading up, the tail trailing straight down off the board
+void SetUpBenchProfile(const BenchProfile& profile, Entity& snake, Entity& fruit, std::vector<Entity>& tails)
+{
+	RestartGame(snake, tails);
+	Global::level = 1;
+	Global::maxLevelScore = 5;
+	snake.SetPosition(Vector(BENCH_LOOP, -BENCH_LOOP), SNAKE_SCALE);
+	fruit.SetPosition(Vector(), FRUIT_SCALE);
+	tails.reserve(profile.tailLength + MAX_TAIL_SEGMENTS);
+	for (int i = 0; i < profile.tailLength; i++)
+		tails.emplace_back(Vector(BENCH_LOOP, -BENCH_LOOP - Global::tailSpacing * (float)(i + 1)), TAIL_SCALE);
+}
+
+// The key the script presses this frame, SDLK_UNKNOWN for none
+SDL_Keycode BenchScriptKey(const Entity& snake)
+{
+	const Vector& p = snake.transform.position;
+	if (Global::dir == eDirection::UP && p.y > BENCH_LOOP)
+		return SDLK_LEFT;
+	if (Global::dir == eDirection::LEFT && p.x < -BENCH_LOOP)
+		return SDLK_DOWN;
+	if (Global::dir == eDirection::DOWN && p.y < -BENCH_LOOP)
+		return SDLK_RIGHT;
+	if (Global::dir == eDirection::RIGHT && p.x > BENCH_LOOP)
+		return SDLK_UP;
+	return SDLK_UNKNOWN;
+}
+
+// One timed frame through the real input, update and render path
+double TimeBenchFrame(Entity& snake, Entity& fruit, Entity& tail, std::vector<Entity>& tails)
+{
+	auto start = std::chrono::steady_clock::now();
+	AllocTracker::Get().BeginFrame();
+	SDL_Event event;
+	HandleInput(event, snake, tails);
+	UpdateGame(snake, fruit, tail, tails);
+	if (!Global::nullRenderer)
+		glClear(GL_COLOR_BUFFER_BIT);
+	RenderGame(snake, fruit, tails);
+	if (!Global::nullRenderer)
+		glFinish();
+	AllocTracker::Get().EndFrame();
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Moves the fixed clock on by one frame of ms
+void AdvanceBenchClock(unsigned int ms)
+{
+	Global::currentTime += ms;
+	Global::previousTime = Global::currentTime;
+	Global::deltaTime = (float)ms / 1000.0f;
+}
+
+void PushBenchKey(SDL_Keycode key, Uint32 type = SDL_KEYDOWN)
+{
+	SDL_Event press = {};
+	press.type = type;
+	press.key.state = type == SDL_KEYDOWN ? SDL_PRESSED : SDL_RELEASED;
+	press.key.keysym.sym = key;
+	SDL_PushEvent(&press);
+}
+
+// Prints ticks per second and frame-time percentiles; false if a frame allocated after the warm-up
+bool ReportBenchRun(const std::string& name, const std::string& detail, std::vector<double>& frameMs, int resets)
+{
+	if (frameMs.empty())
+		return true;
+
+	double totalMs = 0.0;
+	for (double ms : frameMs)
+		totalMs += ms;
+	std::sort(frameMs.begin(), frameMs.end());
+	auto percentile = [&](double p) { return frameMs[std::min(frameMs.size() - 1, (size_t)(p * (double)(frameMs.size() - 1) + 0.5))]; };
+	std::cout << "[Bench] " << name << " (" << detail << ", " << (Global::nullRenderer ? "null" : "gl") << " renderer): "
+		<< frameMs.size() << " frames  resets " << resets << "  ticks/s " << (double)frameMs.size() * 1000.0 / totalMs << "\n";
+	std::cout << "[Bench] " << name << " frame ms mean " << totalMs / (double)frameMs.size()
+		<< " p50 " << percentile(0.50) << " p99 " << percentile(0.99) << " p99.9 " << percentile(0.999)
+		<< " max " << frameMs.back() << std::endl;
+
+	if (!ALLOC_TRACKING || (int)frameMs.size() <= BENCH_WARMUP_FRAMES)
+		return true;
+	const AllocTracker& tracker = AllocTracker::Get();
+	std::cout << "[Bench] " << name << " frames that allocated after warm-up " << tracker.AllocatingFrames()
+		<< " of " << tracker.Frames() << std::endl;
+	if (tracker.AllocatingFrames() == 0)
+		return true;
+	tracker.Report(std::cout);
+	return false;
+}
+
+// False if a frame allocated after the warm-up
+bool RunBenchProfile(const BenchProfile& profile, int frames, Entity& snake, Entity& fruit, Entity& tail, std::vector<Entity>& tails)
+{
+	std::vector<double> frameMs;
+	frameMs.reserve(frames);
+	int resets = 0;
+	SetUpBenchProfile(profile, snake, fruit, tails);
+	for (int frame = 0; frame < frames && Global::appIsRunning; frame++)
+	{
+		Profiler::Get().EndFrame();
+		if (Global::gameOver || Global::level != 1)
+		{
+			SetUpBenchProfile(profile, snake, fruit, tails);
+			resets++;
+		}
+		SDL_Keycode key = BenchScriptKey(snake);
+		if (key != SDLK_UNKNOWN)
+			PushBenchKey(key);
+		AdvanceBenchClock(BENCH_TICK_MS);
+		if (frame == BENCH_WARMUP_FRAMES)
+			AllocTracker::Get().ResetFrames();
+		frameMs.push_back(TimeBenchFrame(snake, fruit, tail, tails));
+	}
+	return ReportBenchRun(profile.name, std::to_string(profile.tailLength) + " tail segments", frameMs, resets);
+}
+
+// The keys HandleInput reads for a replay input
+void PushReplayInput(eReplayInput input)
+{
+	switch (input)
+	{
+	case REPLAY_LEFT: PushBenchKey(SDLK_LEFT); break;
+	case REPLAY_RIGHT: PushBenchKey(SDLK_RIGHT); break;
+	case REPLAY_UP: PushBenchKey(SDLK_UP); break;
+	case REPLAY_DOWN: PushBenchKey(SDLK_DOWN); break;
+	case REPLAY_RESTART: PushBenchKey(SDLK_RETURN); break;
+	case REPLAY_NEXT_DIFFICULTY: PushBenchKey(SDLK_TAB); PushBenchKey(SDLK_TAB, SDL_KEYUP); break;
+	case REPLAY_PAUSE: PushBenchKey(SDLK_SPACE); break;
+	}
+}
+
+// Plays a recorded session from the state WinMain starts the game in, on the replay's own clock
+bool RunBenchReplay(const std::string& path, const Replay& replay, Entity& snake, Entity& fruit, Entity& tail, std::vector<Entity>& tails)
+{
+	Global::rng.Seed(replay.seed);
+	Global::currentTime = replay.startMs;
+	Global::previousTime = replay.startMs;
+	Global::level = 1;
+	Global::score = 0;
+	Global::gameIsPaused = false;
+	Global::tabPressed = false;
+	Global::dX = 0.0f; Global::dY = 0.0f;
+	Global::tailOffset = Vector();
+	Global::fruitSpawnTime = 0;
+	snake.SetPosition(Vector(), SNAKE_SCALE);
+	snake.SetOldPosition(Vector());
+	tails.clear();
+	tails.reserve(MAX_TAIL_SEGMENTS);
+	fruit.SetPosition(GenerateRandomPoint(), FRUIT_SCALE);
+	SetDifficulty(eDifficulty::EASY);
+	GameOver();
+
+	std::vector<double> frameMs;
+	frameMs.reserve(replay.deltaMs.size());
+	int restarts = 0;
+	size_t next = 0;
+	for (uint32_t frame = 0; frame < (uint32_t)replay.deltaMs.size() && Global::appIsRunning; frame++)
+	{
+		Profiler::Get().EndFrame();
+		for (; next < replay.events.size() && replay.events[next].frame == frame; next++)
+		{
+			PushReplayInput((eReplayInput)replay.events[next].input);
+			if (replay.events[next].input == REPLAY_RESTART)
+				restarts++;
+		}
+		AdvanceBenchClock(replay.deltaMs[frame]);
+		if ((int)frame == BENCH_WARMUP_FRAMES)
+			AllocTracker::Get().ResetFrames();
+		frameMs.push_back(TimeBenchFrame(snake, fruit, tail, tails));
+	}
+	std::string name = path.substr(path.find_last_of("/\\") + 1);
+	return ReportBenchRun(name, "replay", frameMs, restarts);
+}
+
+int RunBenchmark(const AppOptions& options)
+{
+	std::vector<const BenchProfile*> profiles;
+	std::stringstream names(options.benchmark);
+	std::string name;
+	while (std::getline(names, name, ','))
+	{
+		size_t before = profiles.size();
+		for (const BenchProfile& profile : BENCH_PROFILES)
+			if (name == "all" || name == profile.name)
+				profiles.push_back(&profile);
+		if (profiles.size() == before)
+		{
+			std::cout << "Unknown benchmark profile: " << name << std::endl;
+			return FAILED;
+		}
+	}
+	std::vector<std::string> replayPaths;
+	std::vector<Replay> replays;
+	std::stringstream paths(options.replays);
+	while (std::getline(paths, name, ','))
+	{
+		replays.emplace_back();
+		if (!replays.back().Load(name))
+		{
+			std::cout << "Cannot read replay " << name << std::endl;
+			return FAILED;
+		}
+		replayPaths.push_back(name);
+	}
+	if (options.benchRenderer != "gl" && options.benchRenderer != "null")
+	{
+		std::cout << "Unknown benchmark renderer: " << options.benchRenderer << std::endl;
+		return FAILED;
+	}
+	if (options.assertNoAlloc && !ALLOC_TRACKING)
+	{
+		std::cout << "--assert-no-alloc needs a build with -DSNAKE_TRACK_ALLOCS" << std::endl;
+		return FAILED;
+	}
+
+	// No sound, the mixer would only add noise to the timings
+	Global::audioEnabled = false;
+	Global::nullRenderer = options.benchRenderer == "null";
+	if (Global::nullRenderer)
+	{
+		if (SDL_Init(0) != 0 || !InitSubsystem(SDL_INIT_EVENTS, "SDL events init"))
+		{
+			std::cout << "Error Initializing SDL: " << SDL_GetError() << std::endl;
+			return FAILED;
+		}
+	}
+	else
+	{
+		Global::hiddenWindow = true;
+		if (SetUpApp(myWindow, myContext) == -1)
+			return FAILED;
+		glViewport(0, 0, WIDTH, HEIGHT);
+		glClearColor(0.1f, 0.8f, 0.3f, 1.0f);
+	}
+
+	Global::rng.Seed(1);
+	SetDifficulty(eDifficulty::EASY);
+	Entity snake(Vector(), SNAKE_SCALE);
+	Entity fruit(Vector(), FRUIT_SCALE);
+	Entity tail;
+	std::vector<Entity> tails;
+	bool allocationFree = true;
+	for (const BenchProfile* profile : profiles)
+		allocationFree = RunBenchProfile(*profile, options.benchFrames, snake, fruit, tail, tails) && allocationFree;
+	for (size_t i = 0; i < replays.size(); i++)
+		allocationFree = RunBenchReplay(replayPaths[i], replays[i], snake, fruit, tail, tails) && allocationFree;
+
+	if (Global::nullRenderer)
+		SDL_Quit();
+	else
+		CleanUpApp(myWindow, myContext);
+	if (options.assertNoAlloc && !allocationFree)
+	{
+		std::cout << "FAILED: the steady-state loop allocated" << std::endl;
+		return FAILED;
+	}
+	return SUCCESS;
+}
+
 // **********************************************************************************************
 //	Application Entry Point
 // **********************************************************************************************
 
 int WinMain(int argc, char* argv[])
 {
+	AppOptions options = ParseArguments(argc, argv);
+	Global::audioBufferFrames = options.audioBufferFrames;
+	Global::audioReport = options.audioReport;
+	Global::musicPath = options.musicPath;
+	Global::synthAudio = options.synthAudio;
+	Global::startupReport = options.startupReport;
+	Global::audioEnabled = !options.noAudio;
+	Global::hotReload = options.hotReload;
+	Global::statsReport = options.statsReport;
+	// Allocation tracking builds always show their counts
+	Global::profilerOverlay = options.profile || ALLOC_TRACKING;
+	Profiler::Get().SetEnabled(options.profile || !options.profileCsv.empty());
+	if (!options.profileCsv.empty() && !Profiler::Get().OpenCsv(options.profileCsv))
+		std::cout << "Cannot write " << options.profileCsv << std::endl;
+	Profiler::Get().NameThread("main");
+	if (options.traceFrames > 0)
+	{
+		Global::traceFrames = options.traceFrames;
+		Global::trace.Start("trace.json", options.traceFrames);
+	}
+	if (!options.benchmark.empty() || !options.replays.empty())
+		return RunBenchmark(options);
+
 	if (SetUpApp(myWindow, myContext) == -1)
 	{
 		return FAILED;
 	}
 
+	uint64_t seed = (uint64_t)std::time(nullptr);
+	Global::rng.Seed(seed);
+	if (!options.recordPath.empty())
+	{
+		// An hour of 60 Hz frames before the vectors grow
+		Global::replay.Start(seed, Global::previousTime);
+		Global::replay.deltaMs.reserve(60 * 60 * 60);
+		Global::replay.events.reserve(4096);
+		Global::recording = true;
+	}
+	if (!options.metricsPath.empty())
+		SetUpMetrics(options.metricsPath);
+
 	Entity snake(Vector(0.0f, 0.0f), 0.035f);
 	std::vector<Entity> tails;
+	tails.reserve(MAX_TAIL_SEGMENTS);
 	Entity fruit(GenerateRandomPoint(), 0.025f);
 	Entity tail;
 
@@ -798,19 +1821,36 @@ int WinMain(int argc, char* argv[])
 	GameOver();
 	Global::startGame = true;
 
+	std::unique_ptr<Autopilot> autopilot = CreateAutopilot(options);
+	std::unique_ptr<GameState> autopilotState(new GameState());
+	Global::autopilot = autopilot.get();
+	Global::autopilotState = autopilotState.get();
+
 	// Main Game Loop
 	while(Global::appIsRunning)
 	{
+		// Close the previous frame's profile before this frame's scopes start
+		Global::gpuTimers.EndFrame();
+		Profiler::Get().EndFrame();
+		Global::trace.EndFrame();
+		AllocTracker::Get().EndFrame();
+		AllocTracker::Get().BeginFrame();
+		RecordFrameMetrics(tails);
+		PROFILE_SCOPE("frame");
+
+		ApplyAssetChanges();
 		glViewport(0, 0, WIDTH, HEIGHT); 
 		// Calculating deltaTime
 		Global::currentTime = SDL_GetTicks();
 		Global::deltaTime = (float)(Global::currentTime - Global::previousTime) / 1000.0f;
+		if (Global::recording)
+			Global::replay.AddFrame(Global::currentTime - Global::previousTime);
 		Global::previousTime = Global::currentTime;
 
 		// Handle Input
 		SDL_Event event;
         HandleInput(event, snake, tails);
-
+		UpdateAutopilot(snake, fruit, tails);
 
 		glClear(GL_COLOR_BUFFER_BIT);
 		glClearColor(0.1f, 0.8f, 0.3f, 1.0f);
@@ -819,13 +1859,38 @@ int WinMain(int argc, char* argv[])
 		UpdateGame(snake, fruit, tail, tails);
 		
 		// Update Render Buffer and Render 
+		Global::gpuTimers.Begin("scene");
 		RenderGame(snake, fruit, tails);
+		Global::gpuTimers.End();
+		RenderProfilerOverlay();
 		
 		// Swap Buffer
-		SDL_GL_SwapWindow(myWindow);
+		{
+			PROFILE_SCOPE("swap");
+			SDL_GL_SwapWindow(myWindow);
+		}
+		ReportStartup();
+	}
+
+	if (Global::autopilot)
+		Global::autopilot->Report(std::cout);
+	if (Global::recording)
+	{
+		if (Global::replay.Save(options.recordPath))
+			std::cout << "Replay written to " << options.recordPath << " (" << Global::replay.deltaMs.size() << " frames)" << std::endl;
+		else
+			std::cout << "Failed to write replay " << options.recordPath << std::endl;
 	}
 
 	CleanUpApp(myWindow, myContext);
 	return SUCCESS;
 }
 
+#if !defined(_WIN32)
+// MinGW links WinMain as the entry point; everywhere else it is an ordinary function
+int main(int argc, char* argv[])
+{
+	return WinMain(argc, argv);
+}
+#endif
+
@@ -0,0 +1,233 @@
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include "../src/AssetArchive.h"
+#include "../src/BakedAssets.h"
+#include "../src/OfflineAudio.h"
+
+// **********************************************************************************************
+//	Asset baker
+//	Usage: BakeAssets [assetsDir] [archive] [--font-size=N] [--rate=N] [--channels=N]
+//	Build: g++ -O2 -std=gnu++17 -I../include -I/usr/include/freetype2 ../tools/BakeAssets.cpp -lfreetype -o BakeAssets
+// **********************************************************************************************
+//	Does the work the game would otherwise repeat at every start and writes the results into
+//	assets.pak beside the source files (src/BakedAssets.h):
+//		*.wav  decoded and converted to signed 16-bit PCM at the device rate and channel count
+//		*.ttf  rasterized with FreeType into an 8-bit glyph atlas with metrics for ASCII 32-126
+//	Source files are packed as well, so the game can fall back to them when the device opens
+//	with a different format than the one baked.
+
+struct BakeOptions
+{
+	std::filesystem::path root = "../assets";
+	std::string output = "assets.pak";
+	int fontSize = 16;
+	int rate = 44100;
+	int channels = 2;
+};
+
+template <typename T>
+static void Append(std::vector<uint8_t>& blob, const T& value)
+{
+	const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+	blob.insert(blob.end(), bytes, bytes + sizeof(T));
+}
+
+static void PadTo(std::vector<uint8_t>& blob, size_t alignment)
+{
+	blob.resize((blob.size() + alignment - 1) / alignment * alignment, 0);
+}
+
+static bool BakeAudio(const std::vector<uint8_t>& source, const BakeOptions& options, std::vector<uint8_t>& blob)
+{
+	WavInfo wav;
+	if (!ParseWav(source.data(), source.size(), wav))
+		return false;
+	std::vector<Sint16> samples = ConvertPcm(wav, options.rate, options.channels);
+
+	BakedPcmHeader header = {BAKED_PCM_MAGIC, BAKED_VERSION, (uint32_t)options.rate, (uint16_t)options.channels, 16,
+		(uint32_t)(samples.size() / options.channels), 0};
+	header.dataOffset = (uint32_t)((sizeof(header) + BAKED_PAYLOAD_ALIGNMENT - 1) / BAKED_PAYLOAD_ALIGNMENT * BAKED_PAYLOAD_ALIGNMENT);
+	Append(blob, header);
+	PadTo(blob, BAKED_PAYLOAD_ALIGNMENT);
+	const uint8_t* bytes = reinterpret_cast<const uint8_t*>(samples.data());
+	blob.insert(blob.end(), bytes, bytes + samples.size() * sizeof(Sint16));
+	return true;
+}
+
+static bool BakeFont(FT_Library library, const std::vector<uint8_t>& source, const BakeOptions& options, std::vector<uint8_t>& blob)
+{
+	FT_Face face;
+	if (FT_New_Memory_Face(library, source.data(), (FT_Long)source.size(), 0, &face) != 0)
+		return false;
+	if (FT_Set_Pixel_Sizes(face, 0, (FT_UInt)options.fontSize) != 0)
+	{
+		FT_Done_Face(face);
+		return false;
+	}
+
+	const int firstChar = 32, lastChar = 126, padding = 1;
+	const int glyphCount = lastChar - firstChar + 1;
+	std::vector<GlyphMetrics> glyphs(glyphCount);
+	std::vector<std::vector<uint8_t>> bitmaps(glyphCount);
+
+	for (int i = 0; i < glyphCount; i++)
+	{
+		GlyphMetrics& glyph = glyphs[i];
+		glyph = GlyphMetrics();
+		if (FT_Load_Char(face, (FT_ULong)(firstChar + i), FT_LOAD_RENDER) != 0)
+			continue;
+		FT_GlyphSlot slot = face->glyph;
+		glyph.width = (uint16_t)slot->bitmap.width;
+		glyph.height = (uint16_t)slot->bitmap.rows;
+		glyph.bearingX = (int16_t)slot->bitmap_left;
+		glyph.bearingY = (int16_t)slot->bitmap_top;
+		glyph.advance = (int16_t)(slot->advance.x >> 6);
+		bitmaps[i].resize((size_t)glyph.width * glyph.height);
+		for (unsigned int row = 0; row < slot->bitmap.rows; row++)
+			std::memcpy(bitmaps[i].data() + (size_t)row * glyph.width, slot->bitmap.buffer + row * slot->bitmap.pitch, glyph.width);
+	}
+
+	// Shelf packing: glyphs left to right, a new row when the current one is full
+	const int atlasWidth = 256;
+	int penX = padding, penY = padding, rowHeight = 0;
+	for (GlyphMetrics& glyph : glyphs)
+	{
+		if (penX + glyph.width + padding > atlasWidth)
+		{
+			penX = padding;
+			penY += rowHeight + padding;
+			rowHeight = 0;
+		}
+		glyph.x = (uint16_t)penX;
+		glyph.y = (uint16_t)penY;
+		penX += glyph.width + padding;
+		rowHeight = std::max(rowHeight, (int)glyph.height);
+	}
+	int atlasHeight = 1;
+	while (atlasHeight < penY + rowHeight + padding)
+		atlasHeight <<= 1;
+
+	std::vector<uint8_t> pixels((size_t)atlasWidth * atlasHeight, 0);
+	for (int i = 0; i < glyphCount; i++)
+		for (int row = 0; row < glyphs[i].height; row++)
+			std::memcpy(pixels.data() + (size_t)(glyphs[i].y + row) * atlasWidth + glyphs[i].x,
+				bitmaps[i].data() + (size_t)row * glyphs[i].width, glyphs[i].width);
+
+	FontAtlasHeader header = {};
+	header.magic = BAKED_FONT_MAGIC;
+	header.version = BAKED_VERSION;
+	header.pixelSize = (uint16_t)options.fontSize;
+	header.ascender = (int16_t)(face->size->metrics.ascender >> 6);
+	header.descender = (int16_t)(face->size->metrics.descender >> 6);
+	header.lineHeight = (int16_t)(face->size->metrics.height >> 6);
+	header.atlasWidth = (uint16_t)atlasWidth;
+	header.atlasHeight = (uint16_t)atlasHeight;
+	header.firstChar = (uint16_t)firstChar;
+	header.glyphCount = (uint16_t)glyphCount;
+	header.glyphOffset = (uint32_t)sizeof(header);
+	header.pixelOffset = (uint32_t)((sizeof(header) + glyphs.size() * sizeof(GlyphMetrics) + BAKED_PAYLOAD_ALIGNMENT - 1)
+		/ BAKED_PAYLOAD_ALIGNMENT * BAKED_PAYLOAD_ALIGNMENT);
+	FT_Done_Face(face);
+
+	Append(blob, header);
+	for (const GlyphMetrics& glyph : glyphs)
+		Append(blob, glyph);
+	PadTo(blob, BAKED_PAYLOAD_ALIGNMENT);
+	blob.insert(blob.end(), pixels.begin(), pixels.end());
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	BakeOptions options;
+	int positional = 0;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		std::string value = arg.find('=') != std::string::npos ? arg.substr(arg.find('=') + 1) : "";
+		if (arg.rfind("--font-size=", 0) == 0)
+			options.fontSize = std::clamp(std::atoi(value.c_str()), 4, 128);
+		else if (arg.rfind("--rate=", 0) == 0)
+			options.rate = std::clamp(std::atoi(value.c_str()), 8000, 192000);
+		else if (arg.rfind("--channels=", 0) == 0)
+			options.channels = std::clamp(std::atoi(value.c_str()), 1, 8);
+		else if (positional++ == 0)
+			options.root = arg;
+		else
+			options.output = arg;
+	}
+
+	FT_Library library;
+	if (FT_Init_FreeType(&library) != 0)
+	{
+		std::cout << "Failed to initialize FreeType" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::error_code error;
+	std::vector<std::filesystem::path> files;
+	for (auto it = std::filesystem::recursive_directory_iterator(options.root, error); !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error))
+		if (it->is_regular_file())
+			files.push_back(it->path());
+	if (error)
+	{
+		std::cout << "Failed to read " << options.root.string() << ": " << error.message() << std::endl;
+		return EXIT_FAILURE;
+	}
+	std::sort(files.begin(), files.end());
+
+	ArchiveBuilder builder;
+	bool ok = true;
+	for (const std::filesystem::path& path : files)
+	{
+		std::string name = std::filesystem::relative(path, options.root).generic_string();
+		std::string extension = path.extension().string();
+		std::ifstream in(path, std::ios::binary);
+		std::vector<uint8_t> source((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+		std::vector<uint8_t> baked;
+		std::string bakedName;
+		if (extension == ".wav")
+		{
+			bakedName = BakedAssetName(name, ".pcm");
+			ok = BakeAudio(source, options, baked) && ok;
+		}
+		else if (extension == ".ttf")
+		{
+			bakedName = BakedAssetName(name, ".atlas");
+			ok = BakeFont(library, source, options, baked) && ok;
+		}
+
+		std::cout << name << "  " << source.size() << " bytes";
+		if (!bakedName.empty())
+			std::cout << " -> " << bakedName << "  " << baked.size() << " bytes";
+		std::cout << std::endl;
+
+		ok = builder.Add(name, std::move(source)) && ok;
+		if (!bakedName.empty() && !baked.empty())
+			ok = builder.Add(bakedName, std::move(baked)) && ok;
+	}
+	FT_Done_FreeType(library);
+
+	if (!ok)
+	{
+		std::cout << "Baking failed, " << options.output << " left unchanged" << std::endl;
+		return EXIT_FAILURE;
+	}
+	AssetArchive archive;
+	if (!builder.Write(options.output) || !archive.Open(options.output.c_str()) || !archive.Verify())
+	{
+		std::cout << "Failed to write " << options.output << std::endl;
+		return EXIT_FAILURE;
+	}
+	std::cout << "Baked " << archive.Count() << " entries into " << options.output << std::endl;
+	return EXIT_SUCCESS;
+}
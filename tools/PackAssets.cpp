@@ -0,0 +1,68 @@
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "../src/AssetArchive.h"
+
+// **********************************************************************************************
+//	Asset packer
+//	Usage: PackAssets [assetsDir] [archive]    (defaults ../assets and assets.pak, run from bin/)
+// **********************************************************************************************
+//	Packs every file under assetsDir into one archive for AssetArchive. The game looks for
+//	assets.pak next to its executable, so run this from bin/ after changing anything in assets/.
+
+int main(int argc, char* argv[])
+{
+	std::filesystem::path root = argc > 1 ? argv[1] : "../assets";
+	std::string output = argc > 2 ? argv[2] : "assets.pak";
+
+	std::error_code error;
+	std::vector<std::filesystem::path> files;
+	for (auto it = std::filesystem::recursive_directory_iterator(root, error); !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error))
+		if (it->is_regular_file())
+			files.push_back(it->path());
+	if (error)
+	{
+		std::cout << "Failed to read " << root.string() << ": " << error.message() << std::endl;
+		return EXIT_FAILURE;
+	}
+	std::sort(files.begin(), files.end());
+
+	ArchiveBuilder builder;
+	for (const std::filesystem::path& path : files)
+	{
+		std::string name = std::filesystem::relative(path, root).generic_string();
+		std::ifstream in(path, std::ios::binary);
+		std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+		if (!in.good() && !in.eof())
+		{
+			std::cout << "Failed to read " << path.string() << std::endl;
+			return EXIT_FAILURE;
+		}
+		std::cout << name << "  " << data.size() << " bytes" << std::endl;
+		if (!builder.Add(name, std::move(data)))
+		{
+			std::cout << "Duplicate asset name hash: " << name << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (!builder.Write(output))
+	{
+		std::cout << "Failed to write " << output << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	AssetArchive archive;
+	if (!archive.Open(output.c_str()) || !archive.Verify())
+	{
+		std::cout << "Written archive failed verification: " << output << std::endl;
+		return EXIT_FAILURE;
+	}
+	std::cout << "Packed " << archive.Count() << " assets into " << output << std::endl;
+	return EXIT_SUCCESS;
+}
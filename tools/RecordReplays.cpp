@@ -0,0 +1,133 @@
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "../src/PathAutopilot.h"
+#include "../src/Replay.h"
+
+// **********************************************************************************************
+//	Replay set generator
+//	Usage: RecordReplays [--out=dir] [--count=N] [--seconds=N] [--seed=N]
+// **********************************************************************************************
+//	Records sessions of the pathfinding autopilot playing on the simulation clock, the way
+//	attract mode plays in main.cpp: a decision every 50 ms and RETURN a second after each game
+//	over. Frames alternate 16 and 17 ms for 60 Hz. Session k starts with k TAB presses, so a set
+//	of three covers easy, medium and hard. The files go to dir/session-k.replay.
+//
+//	Every file is read back and played again through PlayReplayFrame; the program exits with
+//	EXIT_FAILURE if a replay does not end in the state it was recorded in.
+
+const uint32_t DECISION_MS = 50;
+const uint32_t RESTART_MS = 1000;
+
+// Head, score, length and clock of the final state
+static uint64_t StateHash(const GameState& s)
+{
+	uint64_t hash = 1469598103934665603ull;
+	auto mix = [&](uint64_t value) { hash = (hash ^ value) * 1099511628211ull; };
+	mix((uint64_t)(int64_t)(s.head.x * 1e6f));
+	mix((uint64_t)(int64_t)(s.head.y * 1e6f));
+	mix(s.score);
+	mix(s.level);
+	mix(s.tailCount);
+	mix(s.currentTime);
+	mix(s.rng.state);
+	return hash;
+}
+
+int main(int argc, char* argv[])
+{
+	std::string outDir = "../replays";
+	int count = 3;
+	int seconds = 300;
+	uint64_t seed = 1;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg.rfind("--out=", 0) == 0)
+			outDir = arg.substr(6);
+		else if (arg.rfind("--count=", 0) == 0)
+			count = std::atoi(arg.c_str() + 8);
+		else if (arg.rfind("--seconds=", 0) == 0)
+			seconds = std::atoi(arg.c_str() + 10);
+		else if (arg.rfind("--seed=", 0) == 0)
+			seed = std::strtoull(arg.c_str() + 7, nullptr, 10);
+		else
+		{
+			std::cout << "Unknown argument: " << arg << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	for (int k = 0; k < count; k++)
+	{
+		Replay replay;
+		replay.Start(seed + (uint64_t)k, 0);
+		GameState state;
+		StartReplayState(state, replay);
+		PathAutopilot pilot;
+		uint32_t gameOverTime = state.currentTime;
+		uint32_t nextDecision = 0;
+		int games = 0, fruit = 0;
+		uint32_t frames = (uint32_t)seconds * 60;
+
+		for (uint32_t frame = 0; frame < frames; frame++)
+		{
+			replay.AddFrame(frame % 3 == 0 ? 16 : 17);
+			if (frame == 0)
+				for (int tab = 0; tab < k % 3; tab++)
+					replay.AddInput(REPLAY_NEXT_DIFFICULTY);
+			if (state.gameOver && state.currentTime - gameOverTime > RESTART_MS)
+			{
+				replay.AddInput(REPLAY_RESTART);
+				pilot = PathAutopilot();
+				nextDecision = 0;
+				games++;
+			}
+			else if (!state.gameOver && state.currentTime >= nextDecision)
+			{
+				nextDecision = state.currentTime + DECISION_MS;
+				eDirection d = pilot.Decide(state);
+				if (d != eDirection::STOP && d != state.dir)
+					replay.AddInput((eReplayInput)d);
+			}
+
+			// Record first, then play the frame through the same path playback takes
+			size_t next = replay.events.size();
+			while (next > 0 && replay.events[next - 1].frame == frame)
+				next--;
+			bool wasOver = state.gameOver;
+			int events = PlayReplayFrame(state, replay, frame, next);
+			fruit += (events & EVENT_ATE_FRUIT) ? 1 : 0;
+			if (state.gameOver && !wasOver)
+				gameOverTime = state.currentTime;
+		}
+
+		std::string path = outDir + "/session-" + std::to_string(k) + ".replay";
+		if (!replay.Save(path))
+		{
+			std::cout << "Failed to write " << path << std::endl;
+			return EXIT_FAILURE;
+		}
+
+		Replay loaded;
+		GameState played;
+		bool ok = loaded.Load(path);
+		if (ok)
+		{
+			StartReplayState(played, loaded);
+			size_t next = 0;
+			for (uint32_t frame = 0; frame < (uint32_t)loaded.deltaMs.size(); frame++)
+				PlayReplayFrame(played, loaded, frame, next);
+		}
+		if (!ok || StateHash(played) != StateHash(state))
+		{
+			std::cout << "FAILED: " << path << " does not play back to the recorded state" << std::endl;
+			return EXIT_FAILURE;
+		}
+		std::cout << path << ": " << frames << " frames, " << replay.events.size() << " inputs, "
+			<< games << " games, " << fruit << " fruit" << std::endl;
+	}
+	return EXIT_SUCCESS;
+}
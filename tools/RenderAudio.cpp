@@ -0,0 +1,120 @@
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include "../src/OfflineAudio.h"
+#include "../src/PathAutopilot.h"
+
+// **********************************************************************************************
+//	Offline deterministic audio render
+//	Usage: RenderAudio [--seconds=N] [--seed=N] [--out=file.wav] [--expect=hash] [--synth]
+// **********************************************************************************************
+//	Plays a fixed-seed game with the pathfinding autopilot on the simulation clock and renders
+//	every sound it triggers through the real AudioMixer. No audio device or window is opened.
+//	The output hash is the same on every run and machine, so --expect works as a golden check:
+//	the program exits with EXIT_FAILURE when the rendered audio changes.
+//
+//	--synth generates the effects with the ChipSynth instead of the WAV clips. Both paths print
+//	how long the effects took to get ready and how many bytes they keep resident.
+
+int main(int argc, char* argv[])
+{
+	int seconds = 30;
+	uint64_t seed = 1;
+	std::string outPath;
+	std::string expect;
+	bool synth = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg.rfind("--seconds=", 0) == 0)
+			seconds = std::atoi(arg.c_str() + 10);
+		else if (arg.rfind("--seed=", 0) == 0)
+			seed = std::strtoull(arg.c_str() + 7, nullptr, 10);
+		else if (arg.rfind("--out=", 0) == 0)
+			outPath = arg.substr(6);
+		else if (arg.rfind("--expect=", 0) == 0)
+			expect = arg.substr(9);
+		else if (arg == "--synth")
+			synth = true;
+		else
+		{
+			std::cout << "Unknown argument: " << arg << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	OfflineAudioRenderer renderer;
+	auto loadStart = std::chrono::steady_clock::now();
+	size_t resident = 0;
+	if (synth)
+	{
+		renderer.UseSynth();
+		resident = ChipSynth::FootprintBytes();
+	}
+	else if (renderer.LoadClip("../assets/audio/carrotnom-92106.wav") &&
+		renderer.LoadClip("../assets/audio/mixkit-retro-game-over-1947.wav"))
+	{
+		resident = renderer.ClipBytes();
+	}
+	else
+	{
+		std::cout << "Failed to load sound assets (run from the bin directory)" << std::endl;
+		return EXIT_FAILURE;
+	}
+	double loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+	std::cout << (synth ? "synthesized" : "WAV") << " effects ready in " << loadMs << " ms, " << resident << " bytes resident" << std::endl;
+
+	const uint32_t tickMs = 16;
+	GameState state;
+	InitGameState(state, seed);
+	PathAutopilot pilot;
+	int games = 1, fruit = 0;
+	uint32_t restartMs = 0;
+
+	for (uint32_t t = 0; t < (uint32_t)seconds * 1000; t += tickMs)
+	{
+		if (state.gameOver)
+		{
+			// Leave the game over sound a second to play, like attract mode in main.cpp
+			restartMs += tickMs;
+			if (restartMs >= 1000)
+			{
+				InitGameState(state, state.rng.Next() + 1ull);
+				pilot = PathAutopilot();
+				restartMs = 0;
+				games++;
+			}
+		}
+		else
+		{
+			SteerGame(state, pilot.Decide(state));
+			int events = StepGame(state, tickMs);
+			fruit += (events & EVENT_ATE_FRUIT) ? 1 : 0;
+			renderer.HandleEvents(events, state.difficulty);
+		}
+		renderer.AdvanceTick(tickMs);
+	}
+
+	uint64_t hash = HashSamples(renderer.Output());
+	char hex[17];
+	std::snprintf(hex, sizeof(hex), "%016" PRIx64, hash);
+	std::cout << "rendered " << renderer.Output().size() / renderer.Channels() << " frames ("
+		<< seconds << " s, " << games << " games, " << fruit << " fruit)  hash " << hex << std::endl;
+
+	if (!outPath.empty() && !WriteWav(outPath.c_str(), renderer.Output(), renderer.Rate(), renderer.Channels()))
+	{
+		std::cout << "Failed to write " << outPath << std::endl;
+		return EXIT_FAILURE;
+	}
+	if (!expect.empty() && expect != hex)
+	{
+		std::cout << "FAILED: expected hash " << expect << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}